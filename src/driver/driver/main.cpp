@@ -44,12 +44,34 @@ namespace {
         }
     }
 
+    void tokenize(std::string_view path)
+    {
+        auto        db       = db::database({});
+        auto const& document = db.documents[read_document(db, path)];
+
+        auto const  start = std::chrono::steady_clock::now();
+        auto        state = lex::state(document.text, document.line_starts);
+        std::size_t count = 0;
+        while (lex::next(state).type != lex::Type::End_of_input) {
+            ++count;
+        }
+        auto const elapsed = std::chrono::steady_clock::now() - start;
+
+        auto const seconds   = std::chrono::duration<double>(elapsed).count();
+        auto const mebibytes = static_cast<double>(document.text.size()) / (1024.0 * 1024.0);
+        std::println("{} tokens in {}, {:.1f} MiB/s",
+                     count,
+                     std::chrono::duration_cast<std::chrono::microseconds>(elapsed),
+                     mebibytes / seconds);
+    }
+
     void parse(std::string_view path)
     {
         auto db     = db::database({});
         auto doc_id = read_document(db, path);
         auto sink   = db::Diagnostic_stream_sink(db, std::cout);
         auto ctx    = par::context(db, doc_id, sink);
+        par::prelex(ctx);
         par::parse(ctx, [](auto const&) {});
     }
 
@@ -77,6 +99,7 @@ Options:
 
 Commands:
     check [PATH]    Analyze the given document and print diagnostics
+    lex [PATH]      Lex the given document and print token throughput
     parse [PATH]    Just parse the given document and print diagnostics
     fmt [PATH]      Format the given document to standard output
     ast [PATH]      Parse and desugar the given document and display its AST)";
@@ -108,6 +131,9 @@ auto main(int argc, char const* const* argv) -> int
         else if (arg == "check") {
             check(next("[PATH]"));
         }
+        else if (arg == "lex") {
+            tokenize(next("[PATH]"));
+        }
         else if (arg == "parse") {
             parse(next("[PATH]"));
         }
@@ -313,6 +313,16 @@ auto ki::lsp::rename_params_from_json(db::Database const& db, Json json) -> Rena
     };
 }
 
+auto ki::lsp::semantic_tokens_delta_params_from_json(db::Database const& db, Json json)
+    -> Semantic_tokens_delta_params
+{
+    auto object = as<Json::Object>(std::move(json));
+    return Semantic_tokens_delta_params {
+        .doc_id             = document_identifier_from_json(db, at(object, "textDocument")),
+        .previous_result_id = as<Json::String>(at(object, "previousResultId")),
+    };
+}
+
 auto ki::lsp::document_identifier_params_from_json(db::Database const& db, Json json)
     -> db::Document_id
 {
@@ -820,10 +830,11 @@ auto ki::lsp::markdown_content_to_json(std::string markdown) -> Json
     return Json { std::move(object) };
 }
 
-auto ki::lsp::semantic_tokens_to_json(std::span<Semantic_token const> tokens) -> Json
+auto ki::lsp::encode_semantic_tokens(std::span<Semantic_token const> tokens)
+    -> std::vector<std::uint32_t>
 {
-    Json::Array array;
-    array.reserve(tokens.size() * 5); // Each token is represented by five integers.
+    std::vector<std::uint32_t> data;
+    data.reserve(tokens.size() * 5); // Each token is represented by five integers.
 
     Position prev;
     for (Semantic_token const& token : tokens) {
@@ -833,15 +844,15 @@ auto ki::lsp::semantic_tokens_to_json(std::span<Semantic_token const> tokens) ->
         if (token.position.line != prev.line) {
             prev.column = 0;
         }
-        array.emplace_back(integer_to_json(token.position.line - prev.line));
-        array.emplace_back(integer_to_json(token.position.column - prev.column));
-        array.emplace_back(integer_to_json(token.length));
-        array.emplace_back(integer_to_json(std::to_underlying(token.type)));
-        array.emplace_back(0); // Token modifiers bitmask
+        data.push_back(token.position.line - prev.line);
+        data.push_back(token.position.column - prev.column);
+        data.push_back(token.length);
+        data.push_back(std::to_underlying(token.type));
+        data.push_back(0); // Token modifiers bitmask
         prev = token.position;
     }
 
-    return Json { std::move(array) };
+    return data;
 }
 
 auto ki::lsp::make_notification(Json::String method, Json params) -> Json
@@ -30,6 +30,8 @@ namespace ki::lsp {
         Method_not_found       = -32601,
         Invalid_params         = -32602,
         Parse_error            = -32700,
+        Request_cancelled      = -32800,
+        Content_modified       = -32801,
         Request_failed         = -32803,
     };
 
@@ -53,6 +55,19 @@ namespace ki::lsp {
         Range           range;
     };
 
+    // https://microsoft.github.io/language-server-protocol/specifications/lsp/3.17/specification/#semanticTokensDeltaParams
+    struct Semantic_tokens_delta_params {
+        db::Document_id doc_id;
+        std::string     previous_result_id;
+    };
+
+    // https://microsoft.github.io/language-server-protocol/specifications/lsp/3.17/specification/#semanticTokensEdit
+    struct Semantic_tokens_edit {
+        std::size_t                    start {};
+        std::size_t                    delete_count {};
+        std::span<std::uint32_t const> data;
+    };
+
     // https://microsoft.github.io/language-server-protocol/specifications/lsp/3.17/specification/#renameParams
     struct Rename_params {
         db::Document_id doc_id;
@@ -101,11 +116,12 @@ namespace ki::lsp {
     auto position_params_from_json(db::Database const& db, Json json) -> Position_params;
     auto range_params_from_json(db::Database const& db, Json json) -> Range_params;
     auto rename_params_from_json(db::Database const& db, Json json) -> Rename_params;
+    auto semantic_tokens_delta_params_from_json(db::Database const& db, Json json)
+        -> Semantic_tokens_delta_params;
     auto document_identifier_params_from_json(db::Database const& db, Json json) -> db::Document_id;
 
     auto severity_to_json(Severity severity) -> Json;
     auto markdown_content_to_json(std::string markdown) -> Json;
-    auto semantic_tokens_to_json(std::span<Semantic_token const> tokens) -> Json;
     auto diagnostic_to_json(db::Database const& db, Diagnostic const& diagnostic) -> Json;
     auto diagnostic_params_to_json(db::Database const& db, db::Document_id doc_id) -> Json;
     auto hint_to_json(db::Database const& db, db::Document_id doc_id, db::Inlay_hint hint) -> Json;
@@ -127,6 +143,10 @@ namespace ki::lsp {
     auto completion_item_kind_to_json(db::Symbol_variant variant) -> Json;
 
     auto reference_to_json(Reference reference) -> Json;
+
+    // Encode `tokens` as the integer array of the semantic tokens protocol.
+    auto encode_semantic_tokens(std::span<Semantic_token const> tokens)
+        -> std::vector<std::uint32_t>;
     auto reference_kind_to_json(Reference_kind kind) -> Json;
 
     auto environment_symbols(
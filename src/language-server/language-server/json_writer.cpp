@@ -0,0 +1,199 @@
+#include <libutl/utilities.hpp>
+#include <language-server/json_writer.hpp>
+
+#include <charconv>
+
+using namespace ki;
+
+void ki::lsp::Json_writer::separate()
+{
+    if (std::exchange(m_after_key, false)) {
+        return;
+    }
+    if (not m_is_first.empty()) {
+        if (not m_is_first.back()) {
+            m_buffer.push_back(',');
+        }
+        m_is_first.back() = false;
+    }
+}
+
+void ki::lsp::Json_writer::write_string(std::string_view const string)
+{
+    static constexpr std::string_view hex = "0123456789abcdef";
+
+    m_buffer.push_back('"');
+    for (char const character : string) {
+        switch (character) {
+        case '"':  m_buffer.append("\\\""); break;
+        case '\\': m_buffer.append("\\\\"); break;
+        case '\b': m_buffer.append("\\b"); break;
+        case '\f': m_buffer.append("\\f"); break;
+        case '\n': m_buffer.append("\\n"); break;
+        case '\r': m_buffer.append("\\r"); break;
+        case '\t': m_buffer.append("\\t"); break;
+        default:
+            if (static_cast<unsigned char>(character) < 0x20) {
+                m_buffer.append("\\u00");
+                m_buffer.push_back(hex.at(static_cast<unsigned char>(character) >> 4));
+                m_buffer.push_back(hex.at(static_cast<unsigned char>(character) & 0xf));
+            }
+            else {
+                m_buffer.push_back(character);
+            }
+        }
+    }
+    m_buffer.push_back('"');
+}
+
+void ki::lsp::Json_writer::begin_object()
+{
+    separate();
+    m_buffer.push_back('{');
+    m_is_first.push_back(true);
+}
+
+void ki::lsp::Json_writer::end_object()
+{
+    cpputil::always_assert(not m_is_first.empty() and not m_after_key);
+    m_is_first.pop_back();
+    m_buffer.push_back('}');
+}
+
+void ki::lsp::Json_writer::begin_array()
+{
+    separate();
+    m_buffer.push_back('[');
+    m_is_first.push_back(true);
+}
+
+void ki::lsp::Json_writer::end_array()
+{
+    cpputil::always_assert(not m_is_first.empty() and not m_after_key);
+    m_is_first.pop_back();
+    m_buffer.push_back(']');
+}
+
+void ki::lsp::Json_writer::key(std::string_view const key)
+{
+    cpputil::always_assert(not m_is_first.empty() and not m_after_key);
+    separate();
+    write_string(key);
+    m_buffer.push_back(':');
+    m_after_key = true;
+}
+
+void ki::lsp::Json_writer::null()
+{
+    separate();
+    m_buffer.append("null");
+}
+
+void ki::lsp::Json_writer::boolean(bool const boolean)
+{
+    separate();
+    m_buffer.append(boolean ? "true" : "false");
+}
+
+void ki::lsp::Json_writer::number(std::int64_t const number)
+{
+    separate();
+    std::array<char, std::numeric_limits<std::int64_t>::digits10 + 2> digits {};
+    auto const [end, error] = std::to_chars(digits.data(), digits.data() + digits.size(), number);
+    cpputil::always_assert(error == std::errc {});
+    m_buffer.append(digits.data(), end);
+}
+
+void ki::lsp::Json_writer::string(std::string_view const string)
+{
+    separate();
+    write_string(string);
+}
+
+void ki::lsp::Json_writer::value(Json const& json)
+{
+    std::visit(
+        utl::Overload {
+            [&](Json::Object const& object) {
+                begin_object();
+                for (auto const& [name, member] : object) {
+                    key(name);
+                    value(member);
+                }
+                end_object();
+            },
+            [&](Json::Array const& array) {
+                begin_array();
+                std::ranges::for_each(array, std::bind_front(&Json_writer::value, this));
+                end_array();
+            },
+            [&](Json::String const& string) { this->string(string); },
+            [&](Json::Number const number) { this->number(number); },
+            [&](Json::Boolean const boolean) { this->boolean(boolean); },
+            [&](auto const&) { null(); },
+        },
+        json.variant);
+}
+
+void ki::lsp::Json_writer::numbers(std::span<std::uint32_t const> const data)
+{
+    begin_array();
+    for (std::uint32_t const number : data) {
+        this->number(number);
+    }
+    end_array();
+}
+
+auto ki::lsp::Json_writer::checkpoint() const -> Checkpoint
+{
+    return Checkpoint {
+        .size      = m_buffer.size(),
+        .depth     = m_is_first.size(),
+        .is_first  = not m_is_first.empty() and m_is_first.back(),
+        .after_key = m_after_key,
+    };
+}
+
+void ki::lsp::Json_writer::rollback(Checkpoint const checkpoint)
+{
+    cpputil::always_assert(checkpoint.size <= m_buffer.size());
+    cpputil::always_assert(checkpoint.depth <= m_is_first.size());
+    m_buffer.resize(checkpoint.size);
+    m_is_first.resize(checkpoint.depth);
+    if (not m_is_first.empty()) {
+        m_is_first.back() = checkpoint.is_first;
+    }
+    m_after_key = checkpoint.after_key;
+}
+
+void ki::lsp::Json_writer::clear() noexcept
+{
+    m_buffer.clear();
+    m_is_first.clear();
+    m_after_key = false;
+}
+
+auto ki::lsp::Json_writer::view() const noexcept -> std::string_view
+{
+    return m_buffer;
+}
+
+void ki::lsp::write_position(Json_writer& writer, Position const position)
+{
+    writer.begin_object();
+    writer.key("line");
+    writer.number(position.line);
+    writer.key("character");
+    writer.number(position.column);
+    writer.end_object();
+}
+
+void ki::lsp::write_range(Json_writer& writer, Range const range)
+{
+    writer.begin_object();
+    writer.key("start");
+    write_position(writer, range.start);
+    writer.key("end");
+    write_position(writer, range.stop);
+    writer.end_object();
+}
@@ -0,0 +1,61 @@
+#ifndef KIELI_LANGUAGE_SERVER_JSON_WRITER
+#define KIELI_LANGUAGE_SERVER_JSON_WRITER
+
+#include <libutl/utilities.hpp>
+#include <language-server/json.hpp>
+
+namespace ki::lsp {
+
+    // Serializes JSON text directly into a buffer, without building a `Json` value first.
+    // Separators are inserted automatically. The buffer is reused between messages.
+    class Json_writer {
+        std::string       m_buffer;
+        std::vector<bool> m_is_first; // For each open container, whether it is still empty.
+        bool              m_after_key {};
+
+        void separate();
+        void write_string(std::string_view string);
+    public:
+        // The state of the writer at some point in time. See `rollback`.
+        struct Checkpoint {
+            std::size_t size {};
+            std::size_t depth {};
+            bool        is_first {};
+            bool        after_key {};
+        };
+
+        void begin_object();
+        void end_object();
+        void begin_array();
+        void end_array();
+
+        // Write an object key. The next value written is its value.
+        void key(std::string_view key);
+
+        void null();
+        void boolean(bool boolean);
+        void number(std::int64_t number);
+        void string(std::string_view string);
+        void value(Json const& json);
+
+        // Write `data` as an array of numbers.
+        void numbers(std::span<std::uint32_t const> data);
+
+        [[nodiscard]] auto checkpoint() const -> Checkpoint;
+
+        // Discard everything written after `checkpoint` was taken. The containers that were open
+        // when `checkpoint` was taken must still be open.
+        void rollback(Checkpoint checkpoint);
+
+        // Discard the buffer contents, but keep its capacity.
+        void clear() noexcept;
+
+        [[nodiscard]] auto view() const noexcept -> std::string_view;
+    };
+
+    void write_position(Json_writer& writer, Position position);
+    void write_range(Json_writer& writer, Range range);
+
+} // namespace ki::lsp
+
+#endif // KIELI_LANGUAGE_SERVER_JSON_WRITER
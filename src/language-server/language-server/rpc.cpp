@@ -1,10 +1,12 @@
 #include <libutl/utilities.hpp>
 #include <language-server/rpc.hpp>
 
+#include <charconv>
+
 void ki::lsp::rpc::write_message(std::ostream& out, std::string_view const message)
 {
-    std::format_to(
-        std::ostreambuf_iterator(out), "Content-Length: {}\r\n\r\n{}", message.size(), message);
+    std::print(out, "Content-Length: {}\r\n\r\n", message.size());
+    out.write(message.data(), cpputil::num::safe_cast<std::streamsize>(message.size()));
 }
 
 auto ki::lsp::rpc::read_message(std::istream& in) -> std::expected<std::string, std::string_view>
@@ -31,3 +33,103 @@ auto ki::lsp::rpc::read_message(std::istream& in) -> std::expected<std::string,
 
     return content;
 }
+
+ki::lsp::rpc::Reader::Reader(std::istream& in) : m_input(in.rdbuf()) {}
+
+auto ki::lsp::rpc::Reader::fill(std::size_t const count) -> bool
+{
+    static constexpr std::size_t initial_capacity = 4096;
+
+    std::size_t const available = m_end - m_begin;
+    if (available >= count) {
+        return true;
+    }
+
+    if (m_begin + count > m_buffer.size()) {
+        // Move the unconsumed input to the front, and grow the buffer if it is still too small.
+        std::copy(m_buffer.begin() + m_begin, m_buffer.begin() + m_end, m_buffer.begin());
+        m_begin = 0;
+        m_end   = available;
+        if (count > m_buffer.size()) {
+            m_buffer.resize(std::max({ count, m_buffer.size() * 2, initial_capacity }));
+        }
+    }
+
+    // Never request more than is already available, because the read would block otherwise.
+    std::size_t const missing = count - available;
+    std::size_t const ready   = cpputil::num::safe_cast<std::size_t>(
+        std::max(m_input->in_avail(), std::streamsize { 0 }));
+    std::size_t const request = std::min(m_buffer.size() - m_end, std::max(missing, ready));
+
+    m_end += cpputil::num::safe_cast<std::size_t>(
+        m_input->sgetn(m_buffer.data() + m_end, cpputil::num::safe_cast<std::streamsize>(request)));
+
+    return m_end - m_begin >= count;
+}
+
+auto ki::lsp::rpc::Reader::read_header_line() -> std::expected<std::string_view, std::string_view>
+{
+    for (std::size_t scanned = 0;;) {
+        void const* const newline
+            = m_begin + scanned == m_end
+                ? nullptr
+                : std::memchr(m_buffer.data() + m_begin + scanned, '\n', m_end - m_begin - scanned);
+        if (newline != nullptr) {
+            char const* const first = m_buffer.data() + m_begin;
+            char const* const last  = static_cast<char const*>(newline);
+            if (last == first or last[-1] != '\r') {
+                return std::unexpected("Header line not terminated by CRLF"sv);
+            }
+            m_begin += cpputil::num::safe_cast<std::size_t>(last - first) + 1;
+            return std::string_view(first, last - 1);
+        }
+        scanned = m_end - m_begin;
+        if (not fill(scanned + 1)) {
+            return std::unexpected("Premature end of input"sv);
+        }
+    }
+}
+
+auto ki::lsp::rpc::Reader::read() -> std::expected<std::string_view, std::string_view>
+{
+    static constexpr std::string_view length_header = "Content-Length:";
+
+    if (m_begin == m_end) {
+        m_begin = m_end = 0;
+    }
+
+    std::optional<std::size_t> content_length;
+    for (;;) {
+        auto const line = read_header_line();
+        if (not line.has_value()) {
+            return std::unexpected(line.error());
+        }
+        if (line.value().empty()) {
+            break;
+        }
+        // Other headers, such as Content-Type, are ignored.
+        if (line.value().starts_with(length_header)) {
+            std::string_view digits = line.value().substr(length_header.size());
+            digits.remove_prefix(std::min(digits.find_first_not_of(' '), digits.size()));
+
+            std::size_t length {};
+            auto const [end, error]
+                = std::from_chars(digits.data(), digits.data() + digits.size(), length);
+            if (error != std::errc {} or end != digits.data() + digits.size()) {
+                return std::unexpected("Missing content length"sv);
+            }
+            content_length = length;
+        }
+    }
+
+    if (not content_length.has_value()) {
+        return std::unexpected("Missing Content-Length header"sv);
+    }
+    if (not fill(content_length.value())) {
+        return std::unexpected("Premature end of input"sv);
+    }
+
+    std::string_view const content(m_buffer.data() + m_begin, content_length.value());
+    m_begin += content_length.value();
+    return content;
+}
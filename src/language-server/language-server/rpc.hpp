@@ -9,6 +9,26 @@ namespace ki::lsp::rpc {
 
     auto read_message(std::istream& in) -> std::expected<std::string, std::string_view>;
 
+    // Reads messages through a receive buffer that is reused between messages, so that message
+    // contents are not copied into a newly allocated string.
+    class Reader {
+        std::streambuf*   m_input {};
+        std::vector<char> m_buffer;
+        std::size_t       m_begin {}; // Start of the unconsumed input in `m_buffer`.
+        std::size_t       m_end {};   // End of the buffered input in `m_buffer`.
+
+        // Ensure that at least `count` unconsumed bytes are buffered.
+        auto fill(std::size_t count) -> bool;
+
+        // Read a header line, without its terminating CRLF. An empty line ends the headers.
+        auto read_header_line() -> std::expected<std::string_view, std::string_view>;
+    public:
+        explicit Reader(std::istream& in);
+
+        // Read the content of the next message. The view is valid until the next call.
+        auto read() -> std::expected<std::string_view, std::string_view>;
+    };
+
 } // namespace ki::lsp::rpc
 
 #endif // KIELI_LANGUAGE_SERVER_RPC
@@ -3,8 +3,10 @@
 #include <cpputil/json/encode.hpp>
 #include <cpputil/json/format.hpp>
 #include <language-server/json.hpp>
+#include <language-server/json_writer.hpp>
 #include <language-server/rpc.hpp>
 #include <language-server/server.hpp>
+#include <libutl/mailbox.hpp>
 #include <libformat/format.hpp>
 #include <libresolve/resolve.hpp>
 
@@ -12,12 +14,181 @@ using namespace ki;
 using namespace ki::lsp;
 
 namespace {
+    // Why the current job was cancelled.
+    enum struct Cancel_reason : std::uint8_t {
+        Requested,        // The client sent a cancellation request.
+        Content_modified, // The document changed, so the result would be stale.
+    };
+
+    // Coordinates cancellation between the reader thread and the worker. The reader records
+    // received content changes, requests, and cancellation requests. The worker records applied
+    // content changes and the job it is currently working on. When the received and applied
+    // content change counts of a document differ, the document has pending changes, and any
+    // ongoing analysis of the document is stale.
+    class Job_tracker {
+        struct Generations {
+            std::size_t received {};
+            std::size_t applied {};
+        };
+
+        mutable std::mutex                                     m_mutex;
+        std::unordered_map<std::filesystem::path, Generations> m_generations;
+        std::vector<Json>                                      m_queued_request_ids;
+        std::vector<Json>                                      m_cancelled_request_ids;
+        std::optional<Json>                                    m_request_id;
+        std::optional<std::filesystem::path>                   m_watched_path;
+        std::optional<Cancel_reason>                           m_cancel_reason;
+        db::Cancellation_token                                 m_token;
+
+        auto has_pending_changes(std::filesystem::path const& path) const -> bool
+        {
+            auto const it = m_generations.find(path);
+            return it != m_generations.end() and it->second.received != it->second.applied;
+        }
+
+        // The first reason for cancelling the current job is the one reported.
+        void cancel(Cancel_reason const reason)
+        {
+            if (not m_cancel_reason.has_value()) {
+                m_cancel_reason = reason;
+            }
+            db::cancel(m_token);
+        }
+    public:
+        // Called by the reader when a content change to the document at `path` is received.
+        void receive_change(std::filesystem::path const& path)
+        {
+            std::scoped_lock _(m_mutex);
+            ++m_generations[path].received;
+            if (m_watched_path == path) {
+                cancel(Cancel_reason::Content_modified);
+            }
+        }
+
+        // Called by the reader when a request is received.
+        void receive_request(Json id)
+        {
+            std::scoped_lock _(m_mutex);
+            m_queued_request_ids.push_back(std::move(id));
+        }
+
+        // Called by the reader when the client asks for the request with `id` to be cancelled.
+        void receive_cancel(Json const& id)
+        {
+            std::scoped_lock _(m_mutex);
+            if (m_request_id == id) {
+                cancel(Cancel_reason::Requested);
+            }
+            else if (auto it = std::ranges::find(m_queued_request_ids, id);
+                     it != m_queued_request_ids.end()) {
+                m_cancelled_request_ids.push_back(std::move(*it));
+                m_queued_request_ids.erase(it);
+            }
+        }
+
+        // Called by the worker just before a content change to the document at `path` is handled.
+        void apply_change(std::filesystem::path const& path)
+        {
+            std::scoped_lock _(m_mutex);
+            ++m_generations[path].applied;
+        }
+
+        // Called by the worker before a message is handled. Returns the cancellation token of the
+        // new job, or nullopt if the message is a request that was cancelled before it started.
+        auto begin_job(std::optional<Json> const& request_id)
+            -> std::optional<db::Cancellation_token>
+        {
+            std::scoped_lock _(m_mutex);
+            m_request_id.reset();
+            m_watched_path.reset();
+            m_cancel_reason.reset();
+            if (request_id.has_value()) {
+                if (auto it = std::ranges::find(m_cancelled_request_ids, request_id.value());
+                    it != m_cancelled_request_ids.end()) {
+                    m_cancelled_request_ids.erase(it);
+                    return std::nullopt;
+                }
+                std::erase(m_queued_request_ids, request_id.value());
+                m_request_id = request_id;
+            }
+            m_token = db::cancellation_token();
+            return m_token;
+        }
+
+        // Cancel the current job if the document at `path` has or receives pending changes.
+        void watch_document(std::filesystem::path const& path)
+        {
+            std::scoped_lock _(m_mutex);
+            m_watched_path = path;
+            if (has_pending_changes(path)) {
+                cancel(Cancel_reason::Content_modified);
+            }
+        }
+
+        // Called by the worker when the database is reset. Requests and content changes that are
+        // still queued are kept, since the worker has yet to handle them.
+        void reset()
+        {
+            std::scoped_lock _(m_mutex);
+            std::erase_if(m_generations, [](auto const& entry) {
+                return entry.second.received == entry.second.applied;
+            });
+            m_watched_path.reset();
+        }
+
+        // Called by the worker when the current job has been cancelled.
+        [[nodiscard]] auto cancel_reason() const -> Cancel_reason
+        {
+            std::scoped_lock _(m_mutex);
+            return m_cancel_reason.value_or(Cancel_reason::Requested);
+        }
+    };
+
+    using Decoded_message = std::expected<Json, cpputil::json::Parse_error>;
+
+    // A message read from the client by the reader thread.
+    struct Incoming {
+        std::string     text; // Only retained for debug logging.
+        Decoded_message json;
+    };
+
+    // The reader thread pushes `std::nullopt` when it stops reading.
+    using Inbox = utl::Mailbox<std::optional<Incoming>>;
+
+    // The resolution state of an analyzed document, retained so that the next analysis of the
+    // document only has to recompute the queries that were affected by the edits in between.
+    struct Document_analysis {
+        res::Context                 ctx;
+        std::optional<lsp::Position> edit_position;
+        std::size_t                  baseline_size {}; // Arena size after the last full analysis.
+    };
+
+    using Document_analyses
+        = std::unordered_map<db::Document_id, Document_analysis, utl::Hash_vector_index>;
+
+    // The semantic tokens most recently sent to the client for a document. Delta requests are
+    // answered with the difference between these and the current tokens.
+    struct Semantic_tokens_result {
+        std::string                result_id;
+        std::vector<std::uint32_t> data;
+    };
+
+    using Semantic_tokens_results
+        = std::unordered_map<db::Document_id, Semantic_tokens_result, utl::Hash_vector_index>;
+
     struct Server {
-        db::Database       db;
-        std::optional<int> exit_code;
-        std::istream&      input;
-        std::ostream&      output;
-        bool               is_initialized {};
+        db::Database               db;
+        std::optional<int>         exit_code;
+        rpc::Reader                reader;
+        std::ostream&              output;
+        Inbox                      inbox;
+        Job_tracker                jobs;
+        Document_analyses          analyses;
+        Semantic_tokens_results    semantic_tokens;
+        std::size_t                semantic_tokens_count {}; // Used to generate result ids.
+        Json_writer                writer;                   // Reused for every reply.
+        std::atomic<db::Log_level> log_level; // Written by the worker, read by the reader.
+        bool                       is_initialized {};
     };
 
     template <typename T>
@@ -40,6 +211,59 @@ namespace {
         rpc::write_message(server.output, message);
     }
 
+    // Cancel the current job as soon as the client sends a newer change to the document.
+    void watch_document(Server& server, db::Document_id doc_id)
+    {
+        server.jobs.watch_document(db::document_path(server.db, doc_id));
+    }
+
+    // Bring the retained analysis of a document up to date with the edits made to the document
+    // since the analysis and with its edit position. Returns false if the document must be
+    // analyzed from scratch.
+    auto update_analysis(
+        db::Database& db, res::Context& ctx, std::optional<db::Text_edit> const& edit) -> bool
+    {
+        auto& doc = db.documents[ctx.doc_id];
+
+        doc.info.signature_info  = std::nullopt;
+        doc.info.completion_info = std::nullopt;
+
+        if (edit.has_value() and not res::recollect_edit(db, ctx, edit.value())) {
+            return false;
+        }
+
+        // Signature help and completion information is collected while resolving the definition
+        // that contains the edit position, so that definition is resolved again.
+        if (auto const position = doc.edit_position) {
+            bool const is_edited = edit.has_value() and edit->start_line <= position->line
+                               and position->line <= edit->new_stop_line;
+            if (not is_edited) {
+                auto const touch = db::Text_edit {
+                    .offset        = db::text_offset(doc.text, doc.line_starts, position.value()),
+                    .old_length    = 0,
+                    .new_length    = 0,
+                    .start_line    = position->line,
+                    .old_stop_line = position->line,
+                    .new_stop_line = position->line,
+                };
+                return res::recollect_edit(db, ctx, touch);
+            }
+        }
+        return true;
+    }
+
+    auto defined_symbols(res::Context const& ctx) -> std::vector<db::Symbol_id>
+    {
+        return ctx.definitions
+             | std::views::transform(&res::Definition::symbol_id)
+             | std::views::filter([](auto const& symbol_id) { return symbol_id.has_value(); })
+             | std::views::transform([](auto const& symbol_id) { return symbol_id.value(); })
+             | std::ranges::to<std::vector>();
+    }
+
+    // Throws `db::Job_cancelled` if the current job is cancelled during analysis. Cancellation
+    // is only observed between the resolution of two symbols, so a cancelled analysis is retained
+    // and the next analysis resumes where it stopped.
     void analyze_document(Server& server, db::Document_id doc_id)
     {
         auto sink = [&](lsp::Diagnostic diagnostic) {
@@ -49,35 +273,89 @@ namespace {
             }
         };
 
-        auto ctx = res::context(doc_id, sink);
-
-        server.db.documents[doc_id].info = {
-            .diagnostics     = {},
-            .semantic_tokens = {},
-            .inlay_hints     = {},
-            .references      = {},
-            .actions         = {},
-            .root_env_id     = ctx.root_env_id,
-            .signature_info  = std::nullopt,
-            .completion_info = std::nullopt,
-        };
+        // Give up before the retained analysis and the pending edit are consumed.
+        db::check_cancellation(server.db.cancellation);
+
+        auto previous = server.analyses.extract(doc_id);
+
+        std::optional<res::Context> ctx;
+        std::size_t                 baseline_size {};
+        bool                        is_collected = false;
+
+        auto&      doc  = server.db.documents[doc_id];
+        auto const edit = std::exchange(doc.pending_edit, std::nullopt);
+        if (not previous.empty()
+            and res::is_retainable(doc.arena, previous.mapped().baseline_size)) {
+            baseline_size = previous.mapped().baseline_size;
+            ctx.emplace(res::context(std::move(previous.mapped().ctx), std::move(doc.arena), sink));
+        }
 
         try {
-            auto symbol_ids = res::collect_document(server.db, ctx);
+            std::vector<db::Symbol_id> symbol_ids;
+
+            if (ctx.has_value() and update_analysis(server.db, ctx.value(), edit)) {
+                symbol_ids = defined_symbols(ctx.value());
+            }
+            else {
+                ctx.emplace(res::context(doc_id, sink));
+
+                doc.info = {
+                    .diagnostics        = {},
+                    .semantic_tokens    = {},
+                    .inlay_hints        = {},
+                    .references         = {},
+                    .reference_postings = {},
+                    .actions            = {},
+                    .root_env_id        = ctx.value().root_env_id,
+                    .signature_info     = std::nullopt,
+                    .completion_info    = std::nullopt,
+                };
+
+                symbol_ids    = res::collect_document(server.db, ctx.value());
+                baseline_size = ctx.value().arena.ast.expressions.size();
+            }
+            is_collected = true;
 
             for (db::Symbol_id symbol_id : symbol_ids) {
-                res::resolve_symbol(server.db, ctx, symbol_id);
+                res::resolve_symbol(server.db, ctx.value(), symbol_id);
             }
             for (db::Symbol_id symbol_id : symbol_ids) {
-                res::warn_if_unused(server.db, ctx, symbol_id);
+                res::warn_if_unused(server.db, ctx.value(), symbol_id);
             }
         }
         catch (db::Max_errors_reached const& error) {
             auto message = std::format("{} errors occurred, stopping analysis", error.count);
             sink(lsp::error(lsp::to_range(lsp::Position {}), std::move(message)));
+            db::index_references(doc.info);
+            doc.arena = std::move(ctx.value().arena);
+            return;
+        }
+        catch (db::Job_cancelled const&) {
+            debug_log(server, "Analysis of document {} cancelled", doc_id.get());
+            db::index_references(doc.info);
+            doc.arena = std::move(ctx.value().arena);
+            if (is_collected) {
+                server.analyses.insert_or_assign(
+                    doc_id,
+                    Document_analysis {
+                        .ctx           = std::move(ctx).value(),
+                        .edit_position = doc.edit_position,
+                        .baseline_size = baseline_size,
+                    });
+            }
+            throw;
         }
 
-        server.db.documents[doc_id].arena = std::move(ctx.arena);
+        db::index_references(doc.info);
+        doc.arena = std::move(ctx.value().arena);
+
+        server.analyses.insert_or_assign(
+            doc_id,
+            Document_analysis {
+                .ctx           = std::move(ctx).value(),
+                .edit_position = doc.edit_position,
+                .baseline_size = baseline_size,
+            });
     }
 
     void update_edit_position(Server& server, db::Document_id doc_id, lsp::Position position)
@@ -85,28 +363,17 @@ namespace {
         auto& doc = server.db.documents[doc_id];
         if (doc.edit_position != position) {
             doc.edit_position = position;
-            analyze_document(server, doc_id);
+            watch_document(server, doc_id);
+            try {
+                analyze_document(server, doc_id);
+            }
+            catch (db::Job_cancelled const&) {
+                doc.edit_position = std::nullopt; // The analysis is incomplete, redo it next time.
+                throw;
+            }
         }
     }
 
-    auto find_reference(std::span<db::Symbol_reference const> references, Position position)
-        -> std::optional<db::Symbol_reference>
-    {
-        // TODO: binary search
-        auto const it = std::ranges::find_if(references, [=](db::Symbol_reference sym) {
-            return range_contains(sym.reference.range, position);
-        });
-        return it != references.end() ? std::optional(*it) : std::nullopt;
-    }
-
-    auto symbol_references(
-        std::span<db::Symbol_reference const> references, db::Symbol_id symbol_id)
-    {
-        return references
-             | std::views::filter([symbol_id](auto ref) { return ref.symbol_id == symbol_id; })
-             | std::views::transform([](auto ref) { return ref.reference; });
-    }
-
     auto handle_formatting(Server& server, Json params) -> Result<Json>
     {
         auto const [doc_id, options] = formatting_params_from_json(server.db, std::move(params));
@@ -137,29 +404,133 @@ namespace {
         return Json { std::move(hints) };
     }
 
-    auto handle_semantic_tokens(Server const& server, Json params) -> Json
+    // Remember `data` as the semantic tokens sent for the document, and give it a new result id.
+    auto store_semantic_tokens(
+        Server& server, db::Document_id doc_id, std::vector<std::uint32_t> data)
+        -> Semantic_tokens_result const&
+    {
+        auto& result     = server.semantic_tokens[doc_id];
+        result.result_id = std::to_string(server.semantic_tokens_count++);
+        result.data      = std::move(data);
+        return result;
+    }
+
+    void write_semantic_tokens_result(Json_writer& writer, Semantic_tokens_result const& result)
+    {
+        writer.begin_object();
+        writer.key("resultId");
+        writer.string(result.result_id);
+        writer.key("data");
+        writer.numbers(result.data);
+        writer.end_object();
+    }
+
+    // Find a single edit that turns `old_data` into `new_data`, by skipping their common prefix
+    // and suffix. Edits between analyses are usually local, so this keeps responses small.
+    auto semantic_tokens_edit(
+        std::span<std::uint32_t const> old_data, std::span<std::uint32_t const> new_data)
+        -> Semantic_tokens_edit
+    {
+        auto const prefix = static_cast<std::size_t>(
+            std::ranges::mismatch(old_data, new_data).in1 - old_data.begin());
+
+        old_data = old_data.subspan(prefix);
+        new_data = new_data.subspan(prefix);
+
+        auto const suffix = static_cast<std::size_t>(
+            std::ranges::mismatch(old_data | std::views::reverse, new_data | std::views::reverse)
+                .in1
+            - old_data.rbegin());
+
+        return Semantic_tokens_edit {
+            .start        = prefix,
+            .delete_count = old_data.size() - suffix,
+            .data         = new_data.first(new_data.size() - suffix),
+        };
+    }
+
+    void handle_semantic_tokens(Server& server, Json params, Json_writer& writer)
     {
         auto doc_id = document_identifier_params_from_json(server.db, std::move(params));
-        auto data   = semantic_tokens_to_json(server.db.documents[doc_id].info.semantic_tokens);
+        auto data   = encode_semantic_tokens(server.db.documents[doc_id].info.semantic_tokens);
+        write_semantic_tokens_result(
+            writer, store_semantic_tokens(server, doc_id, std::move(data)));
+    }
+
+    void handle_semantic_tokens_delta(Server& server, Json params, Json_writer& writer)
+    {
+        auto const [doc_id, previous_id]
+            = semantic_tokens_delta_params_from_json(server.db, std::move(params));
+        auto data = encode_semantic_tokens(server.db.documents[doc_id].info.semantic_tokens);
+
+        // Without the previous result, the client gets the full tokens instead.
+        auto const it = server.semantic_tokens.find(doc_id);
+        if (it == server.semantic_tokens.end() or it->second.result_id != previous_id) {
+            write_semantic_tokens_result(
+                writer, store_semantic_tokens(server, doc_id, std::move(data)));
+            return;
+        }
+
+        auto const edit = semantic_tokens_edit(it->second.data, data);
+
+        writer.begin_object();
+        writer.key("edits");
+        writer.begin_array();
+        if (edit.delete_count != 0 or not edit.data.empty()) {
+            writer.begin_object();
+            writer.key("start");
+            writer.number(cpputil::num::safe_cast<std::int64_t>(edit.start));
+            writer.key("deleteCount");
+            writer.number(cpputil::num::safe_cast<std::int64_t>(edit.delete_count));
+            writer.key("data");
+            writer.numbers(edit.data);
+            writer.end_object();
+        }
+        writer.end_array();
+        writer.key("resultId");
+        writer.string(store_semantic_tokens(server, doc_id, std::move(data)).result_id);
+        writer.end_object();
+    }
+
+    void handle_semantic_tokens_range(Server& server, Json params, Json_writer& writer)
+    {
+        auto const [doc_id, range] = range_params_from_json(server.db, std::move(params));
+
+        // The tokens are sorted by position, so the tokens in range are contiguous.
+        std::span<Semantic_token const> tokens = server.db.documents[doc_id].info.semantic_tokens;
 
-        Json::Object result;
-        result.try_emplace("data", std::move(data));
-        return Json { std::move(result) };
+        auto const position = &Semantic_token::position;
+        auto const first    = std::ranges::lower_bound(tokens, range.start, {}, position);
+        auto const last = std::ranges::lower_bound(first, tokens.end(), range.stop, {}, position);
+
+        writer.begin_object();
+        writer.key("data");
+        writer.numbers(encode_semantic_tokens(std::span(first, last)));
+        writer.end_object();
     }
 
-    auto handle_highlight(Server const& server, Json params) -> Json
+    void handle_highlight(Server& server, Json params, Json_writer& writer)
     {
         auto const [doc_id, position] = position_params_from_json(server.db, std::move(params));
-        auto const& references        = server.db.documents[doc_id].info.references;
+        auto const& info              = server.db.documents[doc_id].info;
 
-        return find_reference(references, position)
-            .transform([&](db::Symbol_reference ref) {
-                auto highlights = symbol_references(references, ref.symbol_id)
-                                | std::views::transform(reference_to_json)
-                                | std::ranges::to<Json::Array>();
-                return Json { std::move(highlights) };
-            })
-            .value_or(Json {});
+        auto const ref = db::find_reference(info.references, position);
+        if (not ref.has_value()) {
+            writer.null();
+            return;
+        }
+
+        writer.begin_array();
+        for (Reference const reference :
+             db::symbol_references(info.reference_postings, ref.value().symbol_id)) {
+            writer.begin_object();
+            writer.key("range");
+            write_range(writer, reference.range);
+            writer.key("kind");
+            writer.value(reference_kind_to_json(reference.kind));
+            writer.end_object();
+        }
+        writer.end_array();
     }
 
     auto handle_completion(Server& server, Json params) -> Json
@@ -172,23 +543,30 @@ namespace {
             .value_or(Json {});
     }
 
-    auto handle_references(Server const& server, Json params) -> Json
+    void handle_references(Server& server, Json params, Json_writer& writer)
     {
         auto const [doc_id, position] = position_params_from_json(server.db, std::move(params));
-        auto const& references        = server.db.documents[doc_id].info.references;
+        auto const& info              = server.db.documents[doc_id].info;
 
-        auto const make_location = [&](Reference ref) {
-            return location_to_json(server.db, { .doc_id = doc_id, .range = ref.range });
-        };
+        auto const ref = db::find_reference(info.references, position);
+        if (not ref.has_value()) {
+            writer.null();
+            return;
+        }
 
-        return find_reference(references, position)
-            .transform([&](db::Symbol_reference ref) {
-                auto locations = symbol_references(references, ref.symbol_id)
-                               | std::views::transform(make_location)
-                               | std::ranges::to<Json::Array>();
-                return Json { std::move(locations) };
-            })
-            .value_or(Json {});
+        auto const uri = path_to_uri(db::document_path(server.db, doc_id));
+
+        writer.begin_array();
+        for (Reference const reference :
+             db::symbol_references(info.reference_postings, ref.value().symbol_id)) {
+            writer.begin_object();
+            writer.key("uri");
+            writer.string(uri);
+            writer.key("range");
+            write_range(writer, reference.range);
+            writer.end_object();
+        }
+        writer.end_array();
     }
 
     auto handle_signature_help(Server& server, Json params) -> Json
@@ -206,7 +584,7 @@ namespace {
         auto const [doc_id, position] = position_params_from_json(server.db, std::move(params));
         auto const& doc               = server.db.documents[doc_id];
 
-        return find_reference(doc.info.references, position)
+        return db::find_reference(doc.info.references, position)
             .transform([&](db::Symbol_reference ref) {
                 lsp::Range range = doc.arena.symbols[ref.symbol_id].name.range;
                 return location_to_json(server.db, { .doc_id = doc_id, .range = range });
@@ -219,7 +597,7 @@ namespace {
         auto const [doc_id, position] = position_params_from_json(server.db, std::move(params));
         auto const& doc               = server.db.documents[doc_id];
 
-        return find_reference(doc.info.references, position)
+        return db::find_reference(doc.info.references, position)
             .and_then([&](db::Symbol_reference ref) {
                 return symbol_type(doc.arena, ref.symbol_id); //
             })
@@ -235,7 +613,7 @@ namespace {
     auto handle_hover(Server const& server, Json params) -> Result<Json>
     {
         auto const [doc_id, position] = position_params_from_json(server.db, std::move(params));
-        return find_reference(server.db.documents[doc_id].info.references, position)
+        return db::find_reference(server.db.documents[doc_id].info.references, position)
             .transform([&](db::Symbol_reference ref) {
                 std::string markdown = symbol_documentation(server.db, doc_id, ref.symbol_id);
 
@@ -276,7 +654,7 @@ namespace {
         auto const [doc_id, position] = position_params_from_json(server.db, std::move(params));
         auto const& references        = server.db.documents[doc_id].info.references;
 
-        return find_reference(references, position)
+        return db::find_reference(references, position)
             .transform([&](db::Symbol_reference ref) -> Json {
                 Json::Object object;
                 object.try_emplace("range", range_to_json(ref.reference.range));
@@ -288,14 +666,14 @@ namespace {
     auto handle_rename(Server const& server, Json params) -> Result<Json>
     {
         auto const [doc_id, position, text] = rename_params_from_json(server.db, std::move(params));
-        auto const& references              = server.db.documents[doc_id].info.references;
+        auto const& info                    = server.db.documents[doc_id].info;
 
         auto make_edit = [&](Reference ref) { return make_text_edit(ref.range, text); };
 
-        return find_reference(references, position)
+        return db::find_reference(info.references, position)
             .transform([&](db::Symbol_reference ref) {
                 auto uri   = path_to_uri(db::document_path(server.db, doc_id));
-                auto edits = symbol_references(references, ref.symbol_id)
+                auto edits = db::symbol_references(info.reference_postings, ref.symbol_id)
                            | std::views::transform(make_edit) //
                            | std::ranges::to<Json::Array>();
 
@@ -349,7 +727,8 @@ namespace {
             { "semanticTokensProvider",
               Json { Json::Object {
                   { "legend", std::move(semantic_tokens_legend) },
-                  { "full", Json { true } },
+                  { "full", Json { Json::Object { { "delta", Json { true } } } } },
+                  { "range", Json { true } },
               } } },
             { "renameProvider",
               Json { Json::Object {
@@ -391,17 +770,39 @@ namespace {
             debug_log(server, "Received shutdown request while uninitialized");
         }
         server.db = db::Database {}; // Reset the compilation database.
+        server.analyses.clear();     // Retained contexts refer to the old database.
+        server.semantic_tokens.clear();
+        server.jobs.reset();
+        server.log_level.store(server.db.config.log_level, std::memory_order_relaxed);
         return Json {};
     }
 
-    auto handle_request(Server& server, std::string_view const method, Json params) -> Result<Json>
+    // Handles a request by writing the result directly, without building a `Json` value.
+    using Streaming_handler = void (*)(Server& server, Json params, Json_writer& writer);
+
+    // Get the handler for requests whose results can be large, if `method` is one.
+    auto streaming_handler(std::string_view const method) -> Streaming_handler
     {
         if (method == "textDocument/semanticTokens/full") {
-            return handle_semantic_tokens(server, std::move(params));
+            return handle_semantic_tokens;
+        }
+        if (method == "textDocument/semanticTokens/full/delta") {
+            return handle_semantic_tokens_delta;
+        }
+        if (method == "textDocument/semanticTokens/range") {
+            return handle_semantic_tokens_range;
         }
         if (method == "textDocument/documentHighlight") {
-            return handle_highlight(server, std::move(params));
+            return handle_highlight;
         }
+        if (method == "textDocument/references") {
+            return handle_references;
+        }
+        return nullptr;
+    }
+
+    auto handle_request(Server& server, std::string_view const method, Json params) -> Result<Json>
+    {
         if (method == "textDocument/completion") {
             return handle_completion(server, std::move(params));
         }
@@ -414,9 +815,6 @@ namespace {
         if (method == "textDocument/typeDefinition") {
             return handle_type_definition(server, std::move(params));
         }
-        if (method == "textDocument/references") {
-            return handle_references(server, std::move(params));
-        }
         if (method == "textDocument/signatureHelp") {
             return handle_signature_help(server, std::move(params));
         }
@@ -451,6 +849,7 @@ namespace {
         if (document.language == "kieli") {
             auto doc_id = db::client_open_document(
                 server.db, std::move(document.path), std::move(document.text));
+            server.analyses.erase(doc_id);
             analyze_document(server, doc_id);
             publish_diagnostics(server, doc_id);
             return {};
@@ -462,6 +861,8 @@ namespace {
     {
         auto doc_id = document_identifier_params_from_json(server.db, std::move(params));
         db::client_close_document(server.db, doc_id);
+        server.analyses.erase(doc_id);
+        server.semantic_tokens.erase(doc_id);
         return {};
     }
 
@@ -474,7 +875,7 @@ namespace {
         auto new_text = as<Json::String>(at(change, "text"));
         if (auto field = maybe_at(change, "range")) {
             auto range = range_from_json(std::move(field).value());
-            db::edit_text(document.text, range, new_text);
+            db::edit_text(document, range, new_text);
 
             // If the change is small, assume the user just typed some characters.
             if (not is_multiline(range) and new_text.size() < 5 and not new_text.contains('\n')) {
@@ -482,7 +883,7 @@ namespace {
             }
         }
         else {
-            document.text = std::move(new_text);
+            db::set_text(document, std::move(new_text));
         }
     }
 
@@ -493,6 +894,9 @@ namespace {
         for (Json change : as<Json::Array>(at(object, "contentChanges"))) {
             apply_content_change(server.db.documents[doc_id], std::move(change));
         }
+        // If the client sends a newer change, the analysis is cancelled, and the diagnostics are
+        // published once the newest change has been analyzed.
+        watch_document(server, doc_id);
         analyze_document(server, doc_id);
         publish_diagnostics(server, doc_id);
         return {};
@@ -503,6 +907,8 @@ namespace {
         auto object      = as<Json::Object>(std::move(params));
         auto settings    = as<Json::Object>(at(object, "settings"));
         server.db.config = database_config_from_json(at(settings, "kieli"));
+        server.log_level.store(server.db.config.log_level, std::memory_order_relaxed);
+        server.analyses.clear(); // The configuration determines what information is collected.
         return {};
     }
 
@@ -529,23 +935,53 @@ namespace {
         return std::unexpected(std::format("Unsupported notification method: {}", method));
     }
 
-    auto dispatch_handle_request(
-        Server& server, std::string_view const method, Json params, Json const& id) -> Json
+    // Write a success response, with a result written by `handler`. If `handler` throws, the
+    // partially written response is discarded.
+    void write_streamed_response(
+        Server& server, Streaming_handler handler, Json params, Json const& id, Json_writer& writer)
+    {
+        auto const checkpoint = writer.checkpoint();
+        try {
+            writer.begin_object();
+            writer.key("jsonrpc");
+            writer.string("2.0");
+            writer.key("result");
+            handler(server, std::move(params), writer);
+            writer.key("id");
+            writer.value(id);
+            writer.end_object();
+        }
+        catch (...) {
+            writer.rollback(checkpoint);
+            throw;
+        }
+    }
+
+    void dispatch_handle_request(
+        Server&                server,
+        std::string_view const method,
+        Json                   params,
+        Json const&            id,
+        Json_writer&           writer)
     {
         if (method == "initialize") {
             if (std::exchange(server.is_initialized, true)) {
                 debug_log(server, "Received duplicate initialize request");
             }
-            return success_response(handle_initialize(), id);
+            writer.value(success_response(handle_initialize(), id));
         }
         else if (not server.is_initialized) {
-            return error_response(Error_code::Server_not_initialized, "Server not initialized", id);
+            writer.value(
+                error_response(Error_code::Server_not_initialized, "Server not initialized", id));
+        }
+        else if (auto const handler = streaming_handler(method)) {
+            write_streamed_response(server, handler, std::move(params), id, writer);
         }
         else if (auto result = handle_request(server, method, std::move(params))) {
-            return success_response(std::move(result).value(), id);
+            writer.value(success_response(std::move(result).value(), id));
         }
         else {
-            return error_response(Error_code::Request_failed, std::move(result).error(), id);
+            writer.value(error_response(Error_code::Request_failed, std::move(result).error(), id));
         }
     }
 
@@ -584,7 +1020,18 @@ namespace {
         return error_response(Error_code::Invalid_params, std::move(message), std::move(id));
     }
 
-    auto dispatch_handle_message_object(Server& server, Json message) -> std::optional<Json>
+    auto request_cancelled_error_response(Json id) -> Json
+    {
+        return error_response(Error_code::Request_cancelled, "Request cancelled", std::move(id));
+    }
+
+    auto content_modified_error_response(Json id) -> Json
+    {
+        return error_response(Error_code::Content_modified, "Content modified", std::move(id));
+    }
+
+    // Write the reply to `message` to `writer`, if the message is a request.
+    void dispatch_handle_message_object(Server& server, Json message, Json_writer& writer)
     {
         std::optional<Json> id;
         try {
@@ -593,102 +1040,256 @@ namespace {
             auto method = as<Json::String>(at(object, "method"));
             auto params = maybe_at(object, "params").value_or(Json {});
 
+            if (auto token = server.jobs.begin_job(id)) {
+                server.db.cancellation = std::move(token).value();
+            }
+            else {
+                debug_log(server, "Dropping cancelled request: {}", method);
+                writer.value(request_cancelled_error_response(std::move(id).value()));
+                return;
+            }
+
             // If there is an id, the message is a request and the client expects a reply.
             // Otherwise, the message is a notification and the client does not expect a reply.
 
             try {
                 if (id.has_value()) {
-                    return dispatch_handle_request(server, method, std::move(params), id.value());
+                    dispatch_handle_request(server, method, std::move(params), id.value(), writer);
                 }
                 else {
                     dispatch_handle_notification(server, method, std::move(params));
-                    return std::nullopt;
                 }
             }
             catch (Bad_json const& bad_json) {
-                return invalid_params_error_response(
-                    bad_json.message, std::move(id).value_or(Json {}));
+                writer.value(invalid_params_error_response(
+                    bad_json.message, std::move(id).value_or(Json {})));
+            }
+            catch (db::Job_cancelled const&) {
+                debug_log(server, "Cancelled: {}", method);
+                if (not id.has_value()) {
+                    return;
+                }
+                if (server.jobs.cancel_reason() == Cancel_reason::Content_modified) {
+                    writer.value(content_modified_error_response(std::move(id).value()));
+                }
+                else {
+                    writer.value(request_cancelled_error_response(std::move(id).value()));
+                }
             }
         }
         catch (Bad_json const& bad_json) {
-            return invalid_request_error_response(
-                bad_json.message, std::move(id).value_or(Json {}));
+            writer.value(
+                invalid_request_error_response(bad_json.message, std::move(id).value_or(Json {})));
         }
     }
 
     // https://www.jsonrpc.org/specification#batch
-    auto dispatch_handle_message_batch(Server& server, Json::Array messages) -> std::optional<Json>
+    void dispatch_handle_message_batch(Server& server, Json::Array messages, Json_writer& writer)
     {
         if (messages.empty()) {
-            return invalid_request_error_response("Empty batch message", Json {});
+            writer.value(invalid_request_error_response("Empty batch message", Json {}));
+            return;
         }
-        Json::Array replies;
+        auto const checkpoint = writer.checkpoint();
+        writer.begin_array();
+        auto const empty_size = writer.view().size();
         for (Json& message : messages) {
-            if (auto reply = dispatch_handle_message_object(server, std::move(message))) {
-                replies.push_back(std::move(reply).value());
-            }
+            dispatch_handle_message_object(server, std::move(message), writer);
         }
-        if (replies.empty()) {
-            return std::nullopt; // The batch contained notifications only, do not reply.
+        if (writer.view().size() == empty_size) {
+            writer.rollback(checkpoint); // The batch contained notifications only, do not reply.
+            return;
         }
-        return Json { std::move(replies) };
+        writer.end_array();
     }
 
-    auto dispatch_handle_message(Server& server, Json message) -> std::optional<Json>
+    void dispatch_handle_message(Server& server, Json message, Json_writer& writer)
     {
         if (message.is_array()) {
-            return dispatch_handle_message_batch(server, std::move(message).as_array());
+            dispatch_handle_message_batch(server, std::move(message).as_array(), writer);
         }
         else {
-            return dispatch_handle_message_object(server, std::move(message));
+            dispatch_handle_message_object(server, std::move(message), writer);
         }
     }
 
-    auto handle_client_message(Server& server, std::string_view message)
-        -> std::optional<std::string>
+    // Write the reply to `message` to `server.writer`. Returns false if there is no reply.
+    auto handle_client_message(Server& server, Decoded_message message) -> bool
     {
-        std::optional<Json> reply;
+        server.writer.clear();
 
-        if (auto json = cpputil::json::decode<Json_config>(message)) {
-            reply = dispatch_handle_message(server, std::move(json).value());
+        if (message.has_value()) {
+            dispatch_handle_message(server, std::move(message).value(), server.writer);
         }
         else {
-            reply = parse_error_response(json.error());
+            server.writer.value(parse_error_response(message.error()));
         }
 
-        return reply.transform(cpputil::json::encode<Json_config>);
+        return not server.writer.view().empty();
+    }
+
+    auto find_member(Json const& json, std::string_view key) -> Json const*
+    {
+        if (auto const* object = std::get_if<Json::Object>(&json.variant)) {
+            if (auto const it = object->find(key); it != object->end()) {
+                return &it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    auto has_method(Json const& message, std::string_view method) -> bool
+    {
+        auto const* json = find_member(message, "method");
+        if (json == nullptr) {
+            return false;
+        }
+        auto const* string = std::get_if<Json::String>(&json->variant);
+        return string != nullptr and *string == method;
+    }
+
+    // If `message` is a didChange notification, get the path of the changed document.
+    auto changed_document_path(Json const& message) -> std::optional<std::filesystem::path>
+    {
+        if (not has_method(message, "textDocument/didChange")) {
+            return std::nullopt;
+        }
+        auto const* params   = find_member(message, "params");
+        auto const* document = params ? find_member(*params, "textDocument") : nullptr;
+        auto const* uri      = document ? find_member(*document, "uri") : nullptr;
+        auto const* string   = uri ? std::get_if<Json::String>(&uri->variant) : nullptr;
+        if (string == nullptr or not string->starts_with("file://")) {
+            return std::nullopt;
+        }
+        return path_from_uri(*string);
+    }
+
+    // Invoke `callback` with each message object, handling batch messages.
+    void for_each_message(Json const& json, std::invocable<Json const&> auto const& callback)
+    {
+        if (auto const* array = std::get_if<Json::Array>(&json.variant)) {
+            std::ranges::for_each(*array, callback);
+        }
+        else {
+            callback(json);
+        }
+    }
+
+    // Called by the worker just before a message is handled.
+    void apply_changes(Server& server, Json const& json)
+    {
+        for_each_message(json, [&](Json const& message) {
+            if (auto path = changed_document_path(message)) {
+                server.jobs.apply_change(path.value());
+            }
+        });
+    }
+
+    // Called by the reader as soon as a message has been read.
+    // Returns true if the message contains an exit notification.
+    auto receive_message(Server& server, Json const& json) -> bool
+    {
+        bool exit = false;
+        for_each_message(json, [&](Json const& message) {
+            if (auto path = changed_document_path(message)) {
+                server.jobs.receive_change(path.value());
+            }
+            else if (has_method(message, "$/cancelRequest")) {
+                // https://microsoft.github.io/language-server-protocol/specifications/lsp/3.17/specification/#cancelRequest
+                auto const* params = find_member(message, "params");
+                if (auto const* id = params ? find_member(*params, "id") : nullptr) {
+                    server.jobs.receive_cancel(*id);
+                }
+            }
+            else if (auto const* id = find_member(message, "id")) {
+                if (find_member(message, "method") != nullptr) {
+                    server.jobs.receive_request(*id);
+                }
+            }
+            exit = exit or has_method(message, "exit");
+        });
+        return exit;
+    }
+
+    // Read client messages until the exit notification or the end of input.
+    // Runs on the main thread, so that it is never blocked by analysis.
+    void read_messages(Server& server)
+    {
+        for (;;) {
+            auto const text = server.reader.read();
+            if (not text.has_value()) {
+                std::println(std::cerr, "Unable to read message, exiting.");
+                break;
+            }
+            auto json = cpputil::json::decode<Json_config>(text.value());
+            bool exit = json.has_value() and receive_message(server, json.value());
+
+            // The text is only needed for debug logging, which the worker may enable at any time.
+            bool const is_debug_logged
+                = server.log_level.load(std::memory_order_relaxed) == db::Log_level::Debug;
+
+            server.inbox.push(
+                Incoming {
+                    .text = is_debug_logged ? std::string(text.value()) : std::string(),
+                    .json = std::move(json),
+                });
+            if (exit) {
+                break;
+            }
+        }
+        server.inbox.push(std::nullopt);
+    }
+
+    // Handle client messages until the exit notification or the end of input.
+    // Runs on a worker thread, which performs all document analysis.
+    void handle_messages(Server& server)
+    {
+        while (not server.exit_code.has_value()) {
+            auto incoming = server.inbox.wait_pop();
+            if (not incoming.has_value()) {
+                break;
+            }
+            auto& [text, json] = incoming.value();
+            debug_log(server, "--> {}", text);
+            if (json.has_value()) {
+                apply_changes(server, json.value());
+            }
+            if (handle_client_message(server, std::move(json))) {
+                debug_log(server, "<-- {}", server.writer.view());
+                rpc::write_message(server.output, server.writer.view());
+            }
+        }
     }
 } // namespace
 
 auto ki::lsp::run_server(db::Configuration config, std::istream& in, std::ostream& out) -> int
 {
+    auto const log_level = config.log_level;
+
     Server server {
-        .db             = db::database(std::move(config)),
-        .exit_code      = std::nullopt,
-        .input          = in,
-        .output         = out,
-        .is_initialized = false,
+        .db                    = db::database(std::move(config)),
+        .exit_code             = std::nullopt,
+        .reader                = rpc::Reader(in),
+        .output                = out,
+        .inbox                 = {},
+        .jobs                  = {},
+        .analyses              = {},
+        .semantic_tokens       = {},
+        .semantic_tokens_count = 0,
+        .writer                = {},
+        .log_level             = log_level,
+        .is_initialized        = false,
     };
 
     debug_log(server, "Starting server.");
 
-    while (not server.exit_code.has_value()) {
-        if (auto const message = rpc::read_message(server.input)) {
-            debug_log(server, "--> {}", message.value());
-            if (auto const reply = handle_client_message(server, message.value())) {
-                debug_log(server, "<-- {}", reply.value());
-                rpc::write_message(server.output, reply.value());
-            }
-        }
-        else {
-            std::println(std::cerr, "Unable to read message, exiting.");
-            return EXIT_FAILURE;
-        }
-    }
+    std::jthread worker(handle_messages, std::ref(server));
+    read_messages(server);
+    worker.join();
 
     debug_log(server, "Stopping server.");
 
-    return server.exit_code.value();
+    return server.exit_code.value_or(EXIT_FAILURE);
 }
 
 auto ki::lsp::default_server_config() -> db::Configuration
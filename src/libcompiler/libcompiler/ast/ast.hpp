@@ -2,6 +2,7 @@
 #define KIELI_LIBCOMPILER_AST
 
 #include <libutl/utilities.hpp>
+#include <libutl/small_vector.hpp>
 #include <libcompiler/compiler.hpp>
 
 /*
@@ -57,8 +58,8 @@ namespace ki::ast {
     using Path_root = std::variant<std::monostate, Path_root_global, Type_id>;
 
     struct Path {
-        Path_root                 root;
-        std::vector<Path_segment> segments;
+        Path_root                          root;
+        utl::Small_vector<Path_segment, 1> segments;
 
         [[nodiscard]] auto head() const -> Path_segment const&;
         [[nodiscard]] auto is_unqualified() const noexcept -> bool;
@@ -145,8 +146,8 @@ namespace ki::ast {
         };
 
         struct Function_call {
-            std::vector<Expression_id> arguments;
-            Expression_id              invocable;
+            utl::Small_vector<Expression_id, 4> arguments;
+            Expression_id                       invocable;
         };
 
         struct Infix_call {
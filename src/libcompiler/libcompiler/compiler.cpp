@@ -118,6 +118,11 @@ auto ki::db::Max_errors_reached::what() const noexcept -> char const*
     return "ki::db::Max_errors_reached";
 }
 
+auto ki::db::Job_cancelled::what() const noexcept -> char const*
+{
+    return "ki::db::Job_cancelled";
+}
+
 // NOLINTNEXTLINE(performance-unnecessary-value-param)
 void ki::db::Diagnostic_stream_sink::operator()(lsp::Diagnostic diagnostic)
 {
@@ -142,6 +147,41 @@ void ki::db::count_diagnostic(db::Database& db, lsp::Severity severity)
     }
 }
 
+auto ki::db::cancellation_token(std::optional<std::chrono::milliseconds> budget)
+    -> Cancellation_token
+{
+    auto token = Cancellation_token {
+        .flag     = std::make_shared<std::atomic_bool>(false),
+        .deadline = std::nullopt,
+    };
+    if (budget.has_value()) {
+        token.deadline = std::chrono::steady_clock::now() + budget.value();
+    }
+    return token;
+}
+
+void ki::db::cancel(Cancellation_token const& token)
+{
+    cpputil::always_assert(token.flag != nullptr);
+    token.flag->store(true, std::memory_order_relaxed);
+}
+
+auto ki::db::is_cancelled(Cancellation_token const& token) -> bool
+{
+    if (token.flag != nullptr and token.flag->load(std::memory_order_relaxed)) {
+        return true;
+    }
+    return token.deadline.has_value()
+       and token.deadline.value() <= std::chrono::steady_clock::now();
+}
+
+void ki::db::check_cancellation(Cancellation_token const& token)
+{
+    if (is_cancelled(token)) {
+        throw Job_cancelled {};
+    }
+}
+
 // NOLINTNEXTLINE(performance-unnecessary-value-param)
 void ki::db::ignore_sink(lsp::Diagnostic diagnostic)
 {
@@ -151,21 +191,25 @@ void ki::db::ignore_sink(lsp::Diagnostic diagnostic)
 auto ki::db::database(Configuration config) -> Database
 {
     return Database {
-        .documents   = {},
-        .paths       = {},
-        .string_pool = {},
-        .config      = std::move(config),
+        .documents    = {},
+        .paths        = {},
+        .string_pool  = {},
+        .config       = std::move(config),
+        .cancellation = {},
     };
 }
 
 auto ki::db::document(std::string text, Ownership ownership) -> Document
 {
+    auto starts = line_starts(text);
     return Document {
         .info          = Document_info {},
         .text          = std::move(text),
+        .line_starts   = std::move(starts),
         .arena         = Arena {},
         .ownership     = ownership,
         .edit_position = std::nullopt,
+        .pending_edit  = std::nullopt,
     };
 }
 
@@ -281,11 +325,147 @@ auto ki::db::text_range(std::string_view text, lsp::Range range) -> std::string_
     return { begin, end };
 }
 
-void ki::db::edit_text(std::string& text, lsp::Range range, std::string_view new_text)
+auto ki::db::line_starts(std::string_view text) -> std::vector<std::uint32_t>
 {
-    auto const where  = text_range(text, range);
-    auto const offset = static_cast<std::size_t>(where.data() - text.data());
-    text.replace(offset, where.size(), new_text);
+    std::vector<std::uint32_t> starts { 0 };
+
+    auto offset = text.find('\n');
+    while (offset != std::string_view::npos) {
+        starts.push_back(cpputil::num::safe_cast<std::uint32_t>(offset + 1));
+        offset = text.find('\n', offset + 1);
+    }
+    return starts;
+}
+
+auto ki::db::text_offset(
+    std::string_view text, std::span<std::uint32_t const> line_starts, lsp::Position position)
+    -> std::uint32_t
+{
+    cpputil::always_assert(position.line < line_starts.size());
+
+    auto const start = line_starts[position.line];
+    auto       stop  = cpputil::num::safe_cast<std::uint32_t>(text.size());
+    if (position.line + 1 < line_starts.size()) {
+        stop = line_starts[position.line + 1] - 1; // Exclude the line feed
+        if (stop != start and text[stop - 1] == '\r') {
+            --stop;
+        }
+    }
+    cpputil::always_assert(start <= stop and stop <= text.size());
+
+    return start + std::min(position.column, stop - start);
+}
+
+auto ki::db::text_position(std::span<std::uint32_t const> line_starts, std::uint32_t offset)
+    -> lsp::Position
+{
+    cpputil::always_assert(not line_starts.empty());
+    auto const it = std::ranges::upper_bound(line_starts, offset) - 1;
+    return lsp::Position {
+        .line   = cpputil::num::safe_cast<std::uint32_t>(it - line_starts.begin()),
+        .column = offset - *it,
+    };
+}
+
+void ki::db::merge_edit(std::optional<Text_edit>& pending, Text_edit const& edit)
+{
+    if (not pending.has_value()) {
+        pending = edit;
+        return;
+    }
+
+    auto const& old = pending.value();
+
+    // The region of the pending edit in the text that `edit` was applied to.
+    std::int64_t start      = old.offset;
+    std::int64_t old_stop   = old.offset + old.old_length;
+    std::int64_t stop       = old.offset + old.new_length;
+    std::int64_t start_line = old.start_line;
+    std::int64_t old_line   = old.old_stop_line;
+    std::int64_t stop_line  = old.new_stop_line;
+
+    // Extend the region to cover `edit`. The text around the region is the same in the previous
+    // text, so the previous end of the region moves by the same amount.
+    auto const edit_stop = static_cast<std::int64_t>(edit.offset) + edit.old_length;
+    if (edit.offset < start) {
+        start      = edit.offset;
+        start_line = edit.start_line;
+    }
+    if (edit_stop > stop) {
+        old_stop += edit_stop - stop;
+        old_line += edit.old_stop_line - stop_line;
+        stop      = edit_stop;
+        stop_line = edit.old_stop_line;
+    }
+
+    // Apply `edit`, which is now within the region.
+    stop += static_cast<std::int64_t>(edit.new_length) - edit.old_length;
+    stop_line += static_cast<std::int64_t>(edit.new_stop_line) - edit.old_stop_line;
+
+    pending = Text_edit {
+        .offset        = cpputil::num::safe_cast<std::uint32_t>(start),
+        .old_length    = cpputil::num::safe_cast<std::uint32_t>(old_stop - start),
+        .new_length    = cpputil::num::safe_cast<std::uint32_t>(stop - start),
+        .start_line    = cpputil::num::safe_cast<std::uint32_t>(start_line),
+        .old_stop_line = cpputil::num::safe_cast<std::uint32_t>(old_line),
+        .new_stop_line = cpputil::num::safe_cast<std::uint32_t>(stop_line),
+    };
+}
+
+void ki::db::set_text(Document& document, std::string text)
+{
+    auto starts = line_starts(text);
+
+    auto const edit = Text_edit {
+        .offset        = 0,
+        .old_length    = cpputil::num::safe_cast<std::uint32_t>(document.text.size()),
+        .new_length    = cpputil::num::safe_cast<std::uint32_t>(text.size()),
+        .start_line    = 0,
+        .old_stop_line = cpputil::num::safe_cast<std::uint32_t>(
+            std::max(document.line_starts.size(), 1UZ) - 1),
+        .new_stop_line = cpputil::num::safe_cast<std::uint32_t>(starts.size() - 1),
+    };
+    merge_edit(document.pending_edit, edit);
+
+    document.line_starts = std::move(starts);
+    document.text        = std::move(text);
+}
+
+void ki::db::edit_text(Document& document, lsp::Range range, std::string_view new_text)
+{
+    cpputil::always_assert(range.start <= range.stop);
+
+    auto&      starts = document.line_starts;
+    auto const begin  = text_offset(document.text, starts, range.start);
+    auto const end    = text_offset(document.text, starts, range.stop);
+
+    document.text.replace(begin, end - begin, new_text);
+
+    // Shift the lines after the range, then replace the lines that started within it.
+    auto const delta = static_cast<std::int64_t>(new_text.size()) - (end - begin);
+    for (std::uint32_t& start : starts | std::views::drop(range.stop.line + 1)) {
+        start = cpputil::num::safe_cast<std::uint32_t>(start + delta);
+    }
+
+    auto inserted = line_starts(new_text);
+    for (std::uint32_t& start : inserted) {
+        start += begin;
+    }
+
+    auto const it = starts.erase(
+        starts.begin() + range.start.line + 1, starts.begin() + range.stop.line + 1);
+    starts.insert(it, inserted.begin() + 1, inserted.end());
+
+    auto const edit = Text_edit {
+        .offset        = begin,
+        .old_length    = end - begin,
+        .new_length    = cpputil::num::safe_cast<std::uint32_t>(new_text.size()),
+        .start_line    = range.start.line,
+        .old_stop_line = range.stop.line,
+        .new_stop_line = cpputil::num::safe_cast<std::uint32_t>(
+            range.start.line + inserted.size() - 1),
+    };
+    merge_edit(document.pending_edit, edit);
 }
 
 void ki::db::add_signature_help(
@@ -352,6 +532,75 @@ void ki::db::add_reference(
     }
 }
 
+void ki::db::sort_references(std::vector<Symbol_reference>& references)
+{
+    // Stable, so that the first reference added at a position is still found first.
+    std::ranges::stable_sort(references, std::ranges::less {}, [](Symbol_reference const& ref) {
+        return ref.reference.range.start;
+    });
+}
+
+auto ki::db::find_reference(std::span<Symbol_reference const> references, lsp::Position position)
+    -> std::optional<Symbol_reference>
+{
+    auto const start = [](Symbol_reference const& ref) { return ref.reference.range.start; };
+
+    // References are names, which do not overlap, so only the references that start at the
+    // closest position at or before `position` can contain it.
+    auto const last = std::ranges::upper_bound(references, position, std::ranges::less {}, start);
+    if (last == references.begin()) {
+        return std::nullopt;
+    }
+    auto const first = std::ranges::lower_bound(
+        references.begin(), last, start(*std::prev(last)), std::ranges::less {}, start);
+
+    auto const it = std::ranges::find_if(first, last, [=](Symbol_reference const& ref) {
+        return lsp::range_contains(ref.reference.range, position);
+    });
+    return it != last ? std::optional(*it) : std::nullopt;
+}
+
+void ki::db::index_references(Document_info& info)
+{
+    sort_references(info.references);
+
+    Reference_postings& postings = info.reference_postings;
+    postings.offsets.clear();
+    postings.references.clear();
+    if (info.references.empty()) {
+        return;
+    }
+
+    std::size_t symbol_count = 0;
+    for (Symbol_reference const& ref : info.references) {
+        symbol_count = std::max(symbol_count, ref.symbol_id.get() + 1);
+    }
+
+    // Counting sort by symbol. References to the same symbol stay ordered by position.
+    postings.offsets.assign(symbol_count + 1, 0);
+    for (Symbol_reference const& ref : info.references) {
+        ++postings.offsets.at(ref.symbol_id.get() + 1);
+    }
+    std::partial_sum(postings.offsets.begin(), postings.offsets.end(), postings.offsets.begin());
+
+    std::vector<std::uint32_t> cursors(postings.offsets.begin(), postings.offsets.end() - 1);
+    postings.references.assign(info.references.size(), info.references.front().reference);
+    for (Symbol_reference const& ref : info.references) {
+        postings.references.at(cursors.at(ref.symbol_id.get())++) = ref.reference;
+    }
+}
+
+auto ki::db::symbol_references(Reference_postings const& postings, Symbol_id symbol_id)
+    -> std::span<lsp::Reference const>
+{
+    if (symbol_id.get() + 1 >= postings.offsets.size()) {
+        return {};
+    }
+    std::size_t const first = postings.offsets.at(symbol_id.get());
+    std::size_t const last  = postings.offsets.at(symbol_id.get() + 1);
+    return std::span(postings.references).subspan(first, last - first);
+}
+
 auto ki::db::symbol_type(Arena const& arena, Symbol_id symbol_id) -> std::optional<hir::Type_id>
 {
     auto const visitor = utl::Overload {
@@ -118,6 +118,13 @@ namespace ki::db {
         Symbol_id      symbol_id;
     };
 
+    // References grouped by symbol in a flat buffer. The references to the symbol with index `i`
+    // are `references[offsets[i]]` up to but not including `references[offsets[i + 1]]`.
+    struct Reference_postings {
+        std::vector<std::uint32_t>  offsets;
+        std::vector<lsp::Reference> references;
+    };
+
     // Arenas necessary for semantic analysis.
     struct Arena {
         ast::Arena ast;
@@ -133,19 +140,33 @@ namespace ki::db {
         std::vector<lsp::Semantic_token> semantic_tokens;
         std::vector<Inlay_hint>          inlay_hints;
         std::vector<Symbol_reference>    references;
+        Reference_postings               reference_postings;
         std::vector<Action>              actions;
         std::optional<Environment_id>    root_env_id;
         std::optional<Signature_info>    signature_info;
         std::optional<Completion_info>   completion_info;
     };
 
+    // A replacement of a region of text. Lines and byte offsets are tracked separately, so the
+    // region can be located in both the previous and the current text.
+    struct Text_edit {
+        std::uint32_t offset {};        // Byte offset of the start of the region.
+        std::uint32_t old_length {};    // Byte length of the region in the previous text.
+        std::uint32_t new_length {};    // Byte length of the region in the current text.
+        std::uint32_t start_line {};    // Line of the start of the region.
+        std::uint32_t old_stop_line {}; // Line of the end of the region in the previous text.
+        std::uint32_t new_stop_line {}; // Line of the end of the region in the current text.
+    };
+
     // In-memory representation of a text document.
     struct Document {
         Document_info                info;
         std::string                  text;
+        std::vector<std::uint32_t>   line_starts; // Byte offset of the start of each line.
         Arena                        arena;
         Ownership                    ownership {};
         std::optional<lsp::Position> edit_position;
+        std::optional<Text_edit>     pending_edit; // Every edit since the pending edit was reset.
     };
 
     // Represents a file read failure.
@@ -173,17 +194,25 @@ namespace ki::db {
         bool                diagnostics     = true;
     };
 
+    // Cooperative cancellation token, shared between a job and the threads that may cancel it.
+    // A default-constructed token is never cancelled.
+    struct Cancellation_token {
+        std::shared_ptr<std::atomic_bool>                    flag;
+        std::optional<std::chrono::steady_clock::time_point> deadline;
+    };
+
     using Document_map    = std::unordered_map<std::filesystem::path, Document_id>;
     using Document_arena  = utl::Index_vector<Document_id, Document>;
     using Diagnostic_sink = cpputil::fn::Function_ref<void(lsp::Diagnostic)>;
 
     // Compiler database.
     struct Database {
-        Document_arena   documents;
-        Document_map     paths;
-        utl::String_pool string_pool;
-        Configuration    config;
-        std::size_t      error_count {};
+        Document_arena     documents;
+        Document_map       paths;
+        utl::String_pool   string_pool;
+        Configuration      config;
+        Cancellation_token cancellation;
+        std::size_t        error_count {};
     };
 
     // Thrown to indicate job termination when a user-configured maximum error count is reached.
@@ -195,6 +224,11 @@ namespace ki::db {
         [[nodiscard]] auto what() const noexcept -> char const* override;
     };
 
+    // Thrown to indicate job termination when the job's cancellation token has been cancelled.
+    struct Job_cancelled : std::exception {
+        [[nodiscard]] auto what() const noexcept -> char const* override;
+    };
+
     // The diagnostic sink for regular compilation. Logs diagnostic messages to the given stream.
     struct Diagnostic_stream_sink {
         Database&     db;
@@ -209,6 +243,19 @@ namespace ki::db {
     // Throws `Max_errors_reached` if `db.config.maximum_errors` has been reached.
     void count_diagnostic(db::Database& db, lsp::Severity severity);
 
+    // Create a cancellation token. If `budget` is given, the token is cancelled once it elapses.
+    [[nodiscard]] auto cancellation_token(
+        std::optional<std::chrono::milliseconds> budget = std::nullopt) -> Cancellation_token;
+
+    // Cancel the job associated with `token`. May be called from any thread.
+    void cancel(Cancellation_token const& token);
+
+    // Check whether `token` has been cancelled or its time budget has elapsed.
+    [[nodiscard]] auto is_cancelled(Cancellation_token const& token) -> bool;
+
+    // Throws `Job_cancelled` if `token` has been cancelled.
+    void check_cancellation(Cancellation_token const& token);
+
     // Diagnostic sink that ignores its argument.
     void ignore_sink(lsp::Diagnostic diagnostic);
 
@@ -254,8 +301,31 @@ namespace ki::db {
     // Terminates program execution if the range is out of bounds.
     [[nodiscard]] auto text_range(std::string_view text, lsp::Range range) -> std::string_view;
 
-    // Replace `range` in `text` with `new_text`.
-    void edit_text(std::string& text, lsp::Range range, std::string_view new_text);
+    // Find the byte offset of the first character of each line in `text`.
+    [[nodiscard]] auto line_starts(std::string_view text) -> std::vector<std::uint32_t>;
+
+    // Convert `position` to a byte offset in `text`, which has the given line start offsets.
+    // A column past the end of its line is clamped to the end of the line, excluding the line
+    // break, as the LSP specification requires.
+    [[nodiscard]] auto text_offset(
+        std::string_view               text,
+        std::span<std::uint32_t const> line_starts,
+        lsp::Position                  position) -> std::uint32_t;
+
+    // Convert the byte `offset` to a position using the line start offsets of a text.
+    [[nodiscard]] auto text_position(
+        std::span<std::uint32_t const> line_starts, std::uint32_t offset) -> lsp::Position;
+
+    // Merge `edit`, which was applied after `pending`, into `pending`. The result is a single
+    // replacement that covers both edits.
+    void merge_edit(std::optional<Text_edit>& pending, Text_edit const& edit);
+
+    // Replace the text of `document` with `text`. The pending edit covers the whole text.
+    void set_text(Document& document, std::string text);
+
+    // Replace `range` in the text of `document` with `new_text`, and merge the replacement into
+    // the pending edit.
+    void edit_text(Document& document, lsp::Range range, std::string_view new_text);
 
     // Add signature help to the document identified by `doc_id`.
     void add_signature_help(
@@ -280,6 +350,20 @@ namespace ki::db {
     // Add a symbol reference to the document identified by `doc_id`.
     void add_reference(Database& db, Document_id doc_id, lsp::Reference ref, Symbol_id symbol_id);
 
+    // Sort references by position, so that they can be searched with `find_reference`.
+    void sort_references(std::vector<Symbol_reference>& references);
+
+    // Find the reference at `position`. `references` must be sorted with `sort_references`.
+    auto find_reference(std::span<Symbol_reference const> references, lsp::Position position)
+        -> std::optional<Symbol_reference>;
+
+    // Sort the references of `info` and group them by symbol. Called when analysis finishes.
+    void index_references(Document_info& info);
+
+    // Get the references to `symbol_id`, ordered by position.
+    auto symbol_references(Reference_postings const& postings, Symbol_id symbol_id)
+        -> std::span<lsp::Reference const>;
+
     // Get the primary type associated with the given symbol.
     auto symbol_type(Arena const& arena, Symbol_id symbol_id) -> std::optional<hir::Type_id>;
 
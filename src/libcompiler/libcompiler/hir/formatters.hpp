@@ -63,16 +63,16 @@ LIBRESOLVE_DECLARE_FORMATTER(ki::hir::Mutability);
 
 LIBRESOLVE_DECLARE_FORMATTER(ki::hir::Function_parameter);
 
-template <typename T>
+template <typename T, typename Allocator>
     requires std::formattable<ki::hir::dtl::With_arena<T>, char>
-struct std::formatter<ki::hir::dtl::With_arena<std::vector<T>>> // NOLINT(cert-dcl58-cpp)
+struct std::formatter<ki::hir::dtl::With_arena<std::vector<T, Allocator>>> // NOLINT(cert-dcl58-cpp)
 {
     static constexpr auto parse(auto& ctx)
     {
         return ctx.begin();
     }
 
-    static auto format(ki::hir::dtl::With_arena<std::vector<T>> const value, auto& ctx)
+    static auto format(ki::hir::dtl::With_arena<std::vector<T, Allocator>> const value, auto& ctx)
         -> decltype(ctx.out())
     {
         auto const wrap = [&](auto const& x) { return value.wrap(x); };
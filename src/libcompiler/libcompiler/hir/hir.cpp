@@ -90,6 +90,105 @@ auto ki::hir::describe_constructor(Constructor_body const& body) -> std::string_
     return std::visit(visitor, body);
 }
 
+namespace {
+    // Appends the fields that determine the identity of a type to `key`.
+    struct Type_key_visitor {
+        std::string& key;
+
+        void add(std::size_t const value) const
+        {
+            auto const bytes
+                = std::bit_cast<std::array<char, 4>>(cpputil::num::safe_cast<std::uint32_t>(value));
+            key.append(bytes.data(), bytes.size());
+        }
+
+        void add(std::span<ki::hir::Type_id const> const type_ids) const
+        {
+            for (ki::hir::Type_id const type_id : type_ids) {
+                add(type_id.get());
+            }
+        }
+
+        void operator()(ki::db::Error const&) const {}
+
+        void operator()(ki::hir::type::Builtin const builtin) const
+        {
+            add(std::to_underlying(builtin));
+        }
+
+        void operator()(ki::hir::type::Array const& array) const
+        {
+            add(array.element_type.get());
+            add(array.length.get());
+        }
+
+        void operator()(ki::hir::type::Slice const& slice) const
+        {
+            add(slice.element_type.get());
+        }
+
+        void operator()(ki::hir::type::Reference const& reference) const
+        {
+            add(reference.referenced_type.get());
+            add(reference.mutability.id.get());
+        }
+
+        void operator()(ki::hir::type::Pointer const& pointer) const
+        {
+            add(pointer.pointee_type.get());
+            add(pointer.mutability.id.get());
+        }
+
+        void operator()(ki::hir::type::Function const& function) const
+        {
+            add(function.return_type.get());
+            add(function.parameter_types);
+        }
+
+        void operator()(ki::hir::type::Structure const& structure) const
+        {
+            add(structure.id.get());
+        }
+
+        void operator()(ki::hir::type::Enumeration const& enumeration) const
+        {
+            add(enumeration.id.get());
+        }
+
+        void operator()(ki::hir::type::Tuple const& tuple) const
+        {
+            add(tuple.types);
+        }
+
+        void operator()(ki::hir::type::Parameterized const& parameterized) const
+        {
+            add(parameterized.tag.value);
+            add(parameterized.id.get());
+        }
+
+        void operator()(ki::hir::type::Variable const&) const
+        {
+            cpputil::unreachable();
+        }
+    };
+} // namespace
+
+auto ki::hir::intern_type(Arena& arena, Type_variant type) -> Type_id
+{
+    cpputil::always_assert(not std::holds_alternative<type::Variable>(type));
+
+    std::string key(1, static_cast<char>(type.index()));
+    std::visit(Type_key_visitor { .key = key }, type);
+
+    if (auto const it = arena.type_ids.find(key); it != arena.type_ids.end()) {
+        return it->second;
+    }
+
+    auto const type_id = arena.types.push(std::move(type));
+    arena.type_ids.emplace(std::move(key), type_id);
+    return type_id;
+}
+
 #define DEFINE_HIR_FORMAT_TO(...)                                     \
     void ki::hir::format_to(                                          \
         std::string&            output,                               \
@@ -2,6 +2,8 @@
 #define KIELI_LIBCOMPILER_HIR
 
 #include <libutl/utilities.hpp>
+#include <libutl/arena_resource.hpp>
+#include <libutl/stable_index_vector.hpp>
 #include <libcompiler/compiler.hpp>
 #include <libcompiler/cst/cst.hpp>
 #include <libcompiler/ast/ast.hpp>
@@ -85,11 +87,11 @@ namespace ki::hir {
         };
 
         struct Array {
-            std::vector<Expression_id> elements;
+            std::pmr::vector<Expression_id> elements;
         };
 
         struct Tuple {
-            std::vector<Expression_id> fields;
+            std::pmr::vector<Expression_id> fields;
         };
 
         struct Loop {
@@ -103,8 +105,8 @@ namespace ki::hir {
         struct Continue {};
 
         struct Block {
-            std::vector<Expression_id> effects;
-            Expression_id              result;
+            std::pmr::vector<Expression_id> effects;
+            Expression_id                   result;
         };
 
         struct Let {
@@ -131,13 +133,13 @@ namespace ki::hir {
         };
 
         struct Function_call {
-            Expression_id              invocable;
-            std::vector<Expression_id> arguments;
+            Expression_id                   invocable;
+            std::pmr::vector<Expression_id> arguments;
         };
 
         struct Initializer {
-            Constructor_id             constructor;
-            std::vector<Expression_id> arguments;
+            Constructor_id                  constructor;
+            std::pmr::vector<Expression_id> arguments;
         };
 
         struct Tuple_field {
@@ -239,12 +241,12 @@ namespace ki::hir {
         };
 
         struct Tuple {
-            std::vector<Type_id> types;
+            std::pmr::vector<Type_id> types;
         };
 
         struct Function {
-            std::vector<Type_id> parameter_types;
-            Type_id              return_type;
+            std::pmr::vector<Type_id> parameter_types;
+            Type_id                   return_type;
         };
 
         struct Structure {
@@ -475,10 +477,17 @@ namespace ki::hir {
     };
 
     struct Arena {
-        utl::Index_vector<Expression_id, Expression>             expressions;
-        utl::Index_vector<Pattern_id, Pattern>                   patterns;
-        utl::Index_vector<Type_id, Type_variant>                 types;
-        utl::Index_vector<Mutability_id, Mutability_variant>     mutabilities;
+        // Backs the child vectors of expressions and types. Declared first so that it is destroyed
+        // after the nodes that refer to it.
+        utl::Arena_resource memory;
+
+        utl::Index_vector<Expression_id, Expression> expressions;
+        utl::Index_vector<Pattern_id, Pattern>       patterns;
+
+        // Unification holds references to types and mutabilities while pushing new ones.
+        utl::Stable_index_vector<Type_id, Type_variant>             types;
+        utl::Stable_index_vector<Mutability_id, Mutability_variant> mutabilities;
+
         utl::Index_vector<Module_id, Module_info>                modules;
         utl::Index_vector<Function_id, Function_info>            functions;
         utl::Index_vector<Structure_id, Structure_info>          structures;
@@ -490,8 +499,15 @@ namespace ki::hir {
         utl::Index_vector<Local_variable_id, Local_variable>     local_variables;
         utl::Index_vector<Local_mutability_id, Local_mutability> local_mutabilities;
         utl::Index_vector<Local_type_id, Local_type>             local_types;
+
+        // Maps the structural key of each interned type to its id. See `intern_type`.
+        std::unordered_map<std::string, Type_id> type_ids;
     };
 
+    // Get the id of a type structurally identical to `type`, adding it to the arena if needed.
+    // Type variables can not be interned, because their solutions are written in place.
+    auto intern_type(Arena& arena, Type_variant type) -> Type_id;
+
     // Get the name of a built-in expression.
     auto builtin_expr_name(expr::Builtin builtin) -> std::string_view;
 
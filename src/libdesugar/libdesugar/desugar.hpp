@@ -7,9 +7,10 @@
 namespace ki::des {
 
     struct Context {
-        cst::Arena const&   cst;
-        ast::Arena          ast;
-        db::Diagnostic_sink add_diagnostic;
+        cst::Arena const&      cst;
+        ast::Arena             ast;
+        db::Diagnostic_sink    add_diagnostic;
+        db::Cancellation_token cancellation;
     };
 
     auto desugar(Context& ctx, cst::Expression const& expression) -> ast::Expression;
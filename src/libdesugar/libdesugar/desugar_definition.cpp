@@ -37,6 +37,7 @@ auto ki::des::desugar(Context& ctx, cst::Constructor const& constructor) -> ast:
 
 auto ki::des::desugar(Context& ctx, cst::Function const& function) -> ast::Function
 {
+    db::check_cancellation(ctx.cancellation);
     return ast::Function {
         .signature = desugar(ctx, function.signature),
         .body      = desugar(ctx, function.body),
@@ -267,7 +267,8 @@ namespace {
         auto operator()(cst::expr::Function_call const& call) const -> ast::Expression_variant
         {
             return ast::expr::Function_call {
-                .arguments = desugar(ctx, call.arguments.value.elements),
+                .arguments = std::ranges::to<utl::Small_vector<ast::Expression_id, 4>>(
+                    std::views::transform(call.arguments.value.elements, desugar(ctx))),
                 .invocable = desugar(ctx, call.invocable),
             };
         }
@@ -107,7 +107,8 @@ auto ki::des::desugar(Context& ctx, cst::Path const& path) -> ast::Path
     };
     return ast::Path {
         .root     = std::visit<ast::Path_root>(root_visitor, path.root),
-        .segments = desugar(ctx, path.segments),
+        .segments = std::ranges::to<utl::Small_vector<ast::Path_segment, 1>>(
+            std::views::transform(path.segments, desugar(ctx))),
     };
 }
 
@@ -178,7 +179,7 @@ auto ki::des::desugar(Context& ctx, cst::Field_init const& field) -> ast::Field_
         return { .name = field.name, .expression = desugar(ctx, field.equals.value().expression) };
     }
     auto segment = ast::Path_segment { .template_arguments = std::nullopt, .name = field.name };
-    auto path    = ast::Path { .root = {}, .segments = utl::to_vector({ std::move(segment) }) };
+    auto path    = ast::Path { .root = {}, .segments = { std::move(segment) } };
     return ast::Field_init {
         .name       = field.name,
         .expression = ctx.ast.expressions.push(std::move(path), field.name.range),
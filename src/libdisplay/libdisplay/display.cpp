@@ -55,12 +55,13 @@ namespace {
         });
     }
 
-    template <displayable T>
+    template <std::ranges::random_access_range Range>
+        requires displayable<std::ranges::range_value_t<Range>>
     void display_vector_node(
         Display_state&         state,
         Last const             last,
         std::string_view const description,
-        std::vector<T> const&  vector)
+        Range const&           vector)
     {
         write_node(state, last, [&] {
             std::println(state.stream, "{}", description);
@@ -763,6 +764,7 @@ void ki::dis::display_document(
         .cst            = par_ctx.arena,
         .ast            = ast::Arena {},
         .add_diagnostic = sink,
+        .cancellation   = db.cancellation,
     };
 
     auto state = Display_state {
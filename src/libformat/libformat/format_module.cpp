@@ -205,5 +205,5 @@ auto ki::fmt::format_document(
 
     std::print(stream, "\n");
 
-    return lsp::Range(lsp::Position {}, par_ctx.lex_state.position);
+    return lsp::Range(lsp::Position {}, lex::position(par_ctx.lex_state));
 }
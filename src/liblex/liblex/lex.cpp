@@ -1,48 +1,17 @@
 #include <libutl/utilities.hpp>
 #include <libcompiler/lsp.hpp>
+#include <libcompiler/db.hpp>
 #include <liblex/lex.hpp>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 using namespace ki;
 using namespace ki::lex;
 
 namespace {
 
-    constexpr auto punctuation_token_map = std::to_array<std::pair<std::string_view, Type>>({
-        { ".", Type::Dot },
-        { ":", Type::Colon },
-        { "::", Type::Double_colon },
-        { "@", Type::At },
-        { "|", Type::Pipe },
-        { "=", Type::Equals },
-        { "&", Type::Ampersand },
-        { "*", Type::Asterisk },
-        { "+", Type::Plus },
-        { "?", Type::Question },
-        { "!", Type::Exclamation },
-        { "\\", Type::Lambda },
-        { "<-", Type::Left_arrow },
-        { "->", Type::Right_arrow },
-    });
-
-    constexpr auto keyword_token_map = std::to_array<std::pair<std::string_view, Type>>({
-        { "let", Type::Let },         { "mut", Type::Mut },       { "if", Type::If },
-        { "else", Type::Else },       { "for", Type::For },       { "in", Type::In },
-        { "while", Type::While },     { "loop", Type::Loop },     { "continue", Type::Continue },
-        { "break", Type::Break },     { "match", Type::Match },   { "ret", Type::Ret },
-        { "fn", Type::Fn },           { "enum", Type::Enum },     { "struct", Type::Struct },
-        { "concept", Type::Concept }, { "impl", Type::Impl },     { "alias", Type::Alias },
-        { "import", Type::Import },   { "export", Type::Export }, { "module", Type::Module },
-        { "sizeof", Type::Sizeof },   { "typeof", Type::Typeof }, { "where", Type::Where },
-        { "immut", Type::Immut },     { "dyn", Type::Dyn },       { "macro", Type::Macro },
-        { "defer", Type::Defer },
-    });
-
-    auto find_token(auto const& map, std::string_view const string) -> std::optional<Type>
-    {
-        auto const it = std::ranges::find(map, string, utl::first);
-        return it != map.end() ? std::optional(it->second) : std::nullopt;
-    }
-
     template <utl::Metastring string>
     constexpr auto is_one_of(char const c) noexcept -> bool
     {
@@ -74,6 +43,195 @@ namespace {
     constexpr auto is_valid_character
         = satisfies_one_of<is_name, is_operator, is_whitespace, is_one_of<"(){}[],'\"">>;
 
+    struct Spelling {
+        std::string_view string;
+        std::string_view description;
+        Type             type {};
+    };
+
+    constexpr auto token_spellings = std::to_array<Spelling>({
+#define KIELI_X_TOKEN_DO(identifier, spelling, description) \
+    { spelling, description, Type::identifier },
+#include <liblex/token-x-macro-table.hpp>
+#undef KIELI_X_TOKEN_DO
+    });
+
+    constexpr auto is_keyword(Spelling const& spelling) -> bool
+    {
+        return spelling.description.starts_with("keyword ");
+    }
+
+    constexpr auto is_punctuation(Spelling const& spelling) -> bool
+    {
+        return std::ranges::all_of(spelling.string, is_operator);
+    }
+
+    constexpr auto keyword_count = std::ranges::count_if(token_spellings, is_keyword);
+
+    constexpr auto keyword_spellings = [] {
+        std::array<Spelling, keyword_count + 2> spellings {};
+        auto it = std::ranges::copy_if(token_spellings, spellings.begin(), is_keyword).out;
+        *it++   = Spelling { .string = "true", .description = {}, .type = Type::Boolean };
+        *it++   = Spelling { .string = "false", .description = {}, .type = Type::Boolean };
+        return spellings;
+    }();
+
+    constexpr auto punctuation_count = std::ranges::count_if(token_spellings, is_punctuation);
+
+    constexpr auto punctuation_spellings = [] {
+        std::array<Spelling, punctuation_count> spellings {};
+        std::ranges::copy_if(token_spellings, spellings.begin(), is_punctuation);
+        return spellings;
+    }();
+
+    // Collision free hash table from spellings to token types. The seed is searched for during
+    // constant evaluation, so the table adapts when the x-macro table changes. A lookup hashes
+    // the length and three bytes of the string and then does a single string comparison.
+    template <std::size_t capacity>
+        requires(std::has_single_bit(capacity))
+    class Perfect_hash_table {
+    public:
+        constexpr explicit Perfect_hash_table(std::span<Spelling const> const spellings)
+        {
+            while (not try_fill(spellings)) {
+                ++m_seed;
+            }
+        }
+
+        [[nodiscard]] constexpr auto find(std::string_view const string) const
+            -> std::optional<Type>
+        {
+            if (string.empty()) {
+                return std::nullopt;
+            }
+            auto const& slot = m_slots[hash(string, m_seed)];
+            return slot.string == string ? std::optional(slot.type) : std::nullopt;
+        }
+
+    private:
+        static constexpr auto hash(std::string_view const string, std::uint32_t const seed)
+            -> std::size_t
+        {
+            auto const byte = [&](std::size_t const index) -> std::uint32_t {
+                return static_cast<unsigned char>(string[index]);
+            };
+            auto key = (static_cast<std::uint32_t>(string.size()) << 24)
+                     | (byte(string.size() / 2) << 16) | (byte(string.size() - 1) << 8) | byte(0);
+            key = (key ^ seed) * 0x9e3779b1U;
+            key = (key ^ (key >> 16)) * 0x85ebca6bU;
+            return (key ^ (key >> 13)) & (capacity - 1);
+        }
+
+        constexpr auto try_fill(std::span<Spelling const> const spellings) -> bool
+        {
+            m_slots = {};
+            for (Spelling const& spelling : spellings) {
+                auto& slot = m_slots[hash(spelling.string, m_seed)];
+                if (not slot.string.empty()) {
+                    return false;
+                }
+                slot = spelling;
+            }
+            return true;
+        }
+
+        std::array<Spelling, capacity> m_slots {};
+        std::uint32_t                  m_seed {};
+    };
+
+    // Keep the load factor at most one quarter so that a seed is found quickly.
+    template <std::size_t size>
+    constexpr auto make_table(std::array<Spelling, size> const& spellings)
+    {
+        return Perfect_hash_table<std::bit_ceil(size * 4)>(spellings);
+    }
+
+    constexpr auto keyword_table     = make_table(keyword_spellings);
+    constexpr auto punctuation_table = make_table(punctuation_spellings);
+
+    // Byte classes that can be tested one byte at a time or, when SSE2 is available,
+    // sixteen bytes at a time. The vector overload yields 0xff for each matching byte.
+
+    struct Whitespace_class {
+        static auto test(char const c) noexcept -> bool
+        {
+            return is_whitespace(c);
+        }
+#ifdef __SSE2__
+        static auto test(__m128i const block) noexcept -> __m128i
+        {
+            auto const space   = _mm_cmpeq_epi8(block, _mm_set1_epi8(' '));
+            auto const newline = _mm_cmpeq_epi8(block, _mm_set1_epi8('\n'));
+            auto const cr      = _mm_cmpeq_epi8(block, _mm_set1_epi8('\r'));
+            auto const tab     = _mm_cmpeq_epi8(block, _mm_set1_epi8('\t'));
+            return _mm_or_si128(_mm_or_si128(space, newline), _mm_or_si128(cr, tab));
+        }
+#endif
+    };
+
+    struct Name_class {
+        static auto test(char const c) noexcept -> bool
+        {
+            return is_name(c);
+        }
+#ifdef __SSE2__
+        static auto in_range(__m128i const block, char const a, char const b) noexcept -> __m128i
+        {
+            return _mm_and_si128(
+                _mm_cmpgt_epi8(block, _mm_set1_epi8(static_cast<char>(a - 1))),
+                _mm_cmplt_epi8(block, _mm_set1_epi8(static_cast<char>(b + 1))));
+        }
+
+        static auto test(__m128i const block) noexcept -> __m128i
+        {
+            auto const lowercase  = in_range(block, 'a', 'z');
+            auto const uppercase  = in_range(block, 'A', 'Z');
+            auto const digit      = in_range(block, '0', '9');
+            auto const underscore = _mm_cmpeq_epi8(block, _mm_set1_epi8('_'));
+            auto const quote      = _mm_cmpeq_epi8(block, _mm_set1_epi8('\''));
+            auto const alphabetic = _mm_or_si128(lowercase, uppercase);
+            return _mm_or_si128(_mm_or_si128(alphabetic, digit), _mm_or_si128(underscore, quote));
+        }
+#endif
+    };
+
+    // Bytes that can not begin a block comment delimiter.
+    struct Comment_body_class {
+        static auto test(char const c) noexcept -> bool
+        {
+            return c != '*' and c != '/';
+        }
+#ifdef __SSE2__
+        static auto test(__m128i const block) noexcept -> __m128i
+        {
+            auto const delimiter = _mm_or_si128(
+                _mm_cmpeq_epi8(block, _mm_set1_epi8('*')),
+                _mm_cmpeq_epi8(block, _mm_set1_epi8('/')));
+            return _mm_andnot_si128(delimiter, _mm_set1_epi8(-1));
+        }
+#endif
+    };
+
+    // Find the first offset at or after `offset` whose byte is not in `Class`.
+    template <typename Class>
+    auto scan(std::string_view const text, std::size_t offset) noexcept -> std::size_t
+    {
+#ifdef __SSE2__
+        for (; offset + sizeof(__m128i) <= text.size(); offset += sizeof(__m128i)) {
+            auto const data   = reinterpret_cast<__m128i const*>(text.data() + offset);
+            auto const hits   = _mm_movemask_epi8(Class::test(_mm_loadu_si128(data)));
+            auto const misses = ~static_cast<unsigned>(hits) & 0xffffU;
+            if (misses != 0) {
+                return offset + std::countr_zero(misses);
+            }
+        }
+#endif
+        while (offset != text.size() and Class::test(text[offset])) {
+            ++offset;
+        }
+        return offset;
+    }
+
     auto current(State const& state) -> char
     {
         return state.text.at(state.offset);
@@ -86,9 +244,29 @@ namespace {
 
     void advance(State& state, std::size_t const distance = 1)
     {
-        for (std::size_t i = 0; i != distance; ++i) {
-            state.position = lsp::advance(state.position, state.text.at(state.offset++));
+        cpputil::always_assert(state.offset + distance <= state.text.size());
+        state.offset += static_cast<std::uint32_t>(distance);
+    }
+
+    // Offsets only move forward while lexing, so the line hint can be advanced linearly.
+    auto sync_position(State& state) -> lsp::Position
+    {
+        auto const& starts = state.line_starts;
+        while (state.line + 1 < starts.size() and starts[state.line + 1] <= state.offset) {
+            ++state.line;
         }
+        return position(state);
+    }
+
+    // The position of `offset`, which is on line `line` or after it.
+    auto position_from(
+        std::span<std::uint32_t const> const starts, std::uint32_t line, std::uint32_t const offset)
+        -> lsp::Position
+    {
+        while (line + 1 < starts.size() and starts[line + 1] <= offset) {
+            ++line;
+        }
+        return lsp::Position { .line = line, .column = offset - starts[line] };
     }
 
     auto extract_current(State& state) -> char
@@ -133,9 +311,32 @@ namespace {
         return state.text.substr(offset, state.offset - offset);
     }
 
+    template <typename Class>
+    void consume(State& state)
+    {
+        state.offset = static_cast<std::uint32_t>(scan<Class>(state.text, state.offset));
+    }
+
+    template <typename Class>
+    auto extract(State& state) -> std::string_view
+    {
+        auto const offset = state.offset;
+        consume<Class>(state);
+        return state.text.substr(offset, state.offset - offset);
+    }
+
+    void skip_line_comment(State& state)
+    {
+        auto const newline = state.text.find('\n', state.offset);
+        state.offset       = newline != std::string_view::npos
+                               ? static_cast<std::uint32_t>(newline)
+                               : static_cast<std::uint32_t>(state.text.size());
+    }
+
     auto skip_block_comment(State& state) -> std::optional<Type>
     {
         for (std::size_t depth = 1; depth != 0;) {
+            consume<Comment_body_class>(state);
             if (try_consume(state, "*/")) {
                 --depth;
             }
@@ -155,9 +356,9 @@ namespace {
     auto skip_comments_and_whitespace(State& state) -> std::optional<Type>
     {
         for (;;) {
-            consume(state, is_whitespace);
+            consume<Whitespace_class>(state);
             if (try_consume(state, "//")) {
-                consume(state, std::not_fn(is_one_of<"\n">));
+                skip_line_comment(state);
             }
             else if (try_consume(state, "/*")) {
                 if (auto error = skip_block_comment(state)) {
@@ -172,14 +373,11 @@ namespace {
 
     auto extract_name(State& state) -> Type
     {
-        auto const string = extract(state, is_name);
+        auto const string = extract<Name_class>(state);
         cpputil::always_assert(not string.empty());
-        if (auto const type = find_token(keyword_token_map, string)) {
+        if (auto const type = keyword_table.find(string)) {
             return type.value();
         }
-        if (string == "true" or string == "false") {
-            return Type::Boolean;
-        }
         auto const head = string.find_first_not_of('_');
         return head == std::string_view::npos ? Type::Underscore
              : is_uppercase(string[head])     ? Type::Upper_name
@@ -189,7 +387,7 @@ namespace {
     auto extract_operator(State& state) -> Type
     {
         auto const string = extract(state, is_operator);
-        return find_token(punctuation_token_map, string).value_or(Type::Operator);
+        return punctuation_table.find(string).value_or(Type::Operator);
     }
 
     auto extract_string_literal(State& state) -> Type
@@ -216,9 +414,9 @@ namespace {
     auto extract_numeric(State& state) -> Type
     {
         bool const has_preceding_dot = state.offset != 0 and state.text.at(state.offset - 1) == '.';
-        consume(state, is_name);
+        consume<Name_class>(state);
         if (not has_preceding_dot and try_consume(state, '.')) {
-            consume(state, is_name);
+            consume<Name_class>(state);
             return Type::Floating;
         }
         return Type::Integer;
@@ -257,9 +455,25 @@ namespace {
 
 } // namespace
 
-auto ki::lex::state(std::string_view text) -> State
+auto ki::lex::state(std::string_view text, std::span<std::uint32_t const> line_starts) -> State
+{
+    cpputil::always_assert(not line_starts.empty());
+    return State { .line_starts = line_starts, .line = 0, .offset = 0, .text = text };
+}
+
+void ki::lex::seek(State& state, std::uint32_t const offset)
 {
-    return State { .position = {}, .offset = 0, .text = text };
+    cpputil::always_assert(offset <= state.text.size());
+    state.offset = offset;
+    state.line   = db::text_position(state.line_starts, offset).line;
+}
+
+auto ki::lex::position(State const& state) -> lsp::Position
+{
+    return lsp::Position {
+        .line   = state.line,
+        .column = state.offset - state.line_starts[state.line],
+    };
 }
 
 auto ki::lex::next(State& state) -> Token
@@ -269,18 +483,61 @@ auto ki::lex::next(State& state) -> Token
     if (is_finished(state)) {
         return Token {
             .type  = Type::End_of_input,
-            .range = lsp::to_range(state.position),
+            .range = lsp::to_range(sync_position(state)),
             .view  = utl::View { .offset = state.offset, .length = 0 },
         };
     }
 
-    auto const position = state.position;
-    auto const offset   = state.offset;
-    auto const type     = extract_token(state);
+    auto const start  = sync_position(state);
+    auto const offset = state.offset;
+    auto const type   = extract_token(state);
 
     return Token {
         .type  = type,
-        .range = lsp::Range(position, state.position),
+        .range = lsp::Range(start, sync_position(state)),
         .view  = utl::View { .offset = offset, .length = state.offset - offset },
     };
 }
+
+auto ki::lex::lex_all(State& state) -> Token_buffer
+{
+    Token_buffer buffer;
+    buffer.line_starts = state.line_starts;
+
+    for (;;) {
+        skip_comments_and_whitespace(state);
+
+        auto const line   = sync_position(state).line;
+        auto const offset = state.offset;
+        auto const type   = is_finished(state) ? Type::End_of_input : extract_token(state);
+
+        buffer.types.push_back(type);
+        buffer.offsets.push_back(offset);
+        buffer.lengths.push_back(state.offset - offset);
+        buffer.lines.push_back(line);
+
+        if (type == Type::End_of_input) {
+            return buffer;
+        }
+    }
+}
+
+auto ki::lex::token(Token_buffer const& buffer, std::size_t const index) -> Token
+{
+    auto const type   = buffer.types.at(index);
+    auto const offset = buffer.offsets.at(index);
+    auto const length = buffer.lengths.at(index);
+    auto const start  = position_from(buffer.line_starts, buffer.lines.at(index), offset);
+
+    // Match `lex::next`, which gives the end of input a range one column wide.
+    auto const range
+        = type == Type::End_of_input
+            ? lsp::to_range(start)
+            : lsp::Range(start, position_from(buffer.line_starts, start.line, offset + length));
+
+    return Token {
+        .type  = type,
+        .range = range,
+        .view  = utl::View { .offset = offset, .length = length },
+    };
+}
@@ -8,17 +8,42 @@
 namespace ki::lex {
 
     struct State {
-        lsp::Position    position;
-        std::uint32_t    offset {};
-        std::string_view text;
+        std::span<std::uint32_t const> line_starts;
+        std::uint32_t                  line {}; // Line containing `offset`.
+        std::uint32_t                  offset {};
+        std::string_view               text;
     };
 
-    // Construct a lexical analysis state.
-    [[nodiscard]] auto state(std::string_view text) -> State;
+    // Tokens of a document as parallel arrays. The last token is always `End_of_input`.
+    struct Token_buffer {
+        std::vector<Type>              types;
+        std::vector<std::uint32_t>     offsets;
+        std::vector<std::uint32_t>     lengths;
+        std::vector<std::uint32_t>     lines; // Line of the start of each token.
+        std::span<std::uint32_t const> line_starts;
+    };
+
+    // Construct a lexical analysis state. `line_starts` must be the line-start table of `text`.
+    [[nodiscard]] auto state(std::string_view text, std::span<std::uint32_t const> line_starts)
+        -> State;
+
+    // Move `state` to `offset`, locating its line by binary search.
+    void seek(State& state, std::uint32_t offset);
+
+    // Compute the position of the current offset of `state`.
+    [[nodiscard]] auto position(State const& state) -> lsp::Position;
 
     // Compute the next token based on `state`.
     [[nodiscard]] auto next(State& state) -> Token;
 
+    // Lex the remainder of `state` into a token buffer. Only the start line of each token is
+    // recorded, columns are computed when a token is reconstructed.
+    [[nodiscard]] auto lex_all(State& state) -> Token_buffer;
+
+    // Reconstruct the token at `index`. The end of a token is found by scanning the line starts
+    // forward from its start line, so no binary search is needed.
+    [[nodiscard]] auto token(Token_buffer const& buffer, std::size_t index) -> Token;
+
 } // namespace ki::lex
 
 #endif // KIELI_LIBLEX_LEX
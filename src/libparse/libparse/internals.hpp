@@ -16,7 +16,8 @@ namespace ki::par {
     // Source range from `range` up to (but not including) the current token.
     [[nodiscard]] auto up_to_current(Context& ctx, lsp::Range range) -> lsp::Range;
 
-    // Add a semantic token corresponding to `range` to the current document.
+    // Add a semantic token corresponding to `range` to the current document, unless there was
+    // a syntax error in the current definition.
     void add_semantic_token(Context& ctx, lsp::Range range, Semantic type);
 
     // Add a keyword semantic token corresponding to `range` to the current document.
@@ -30,11 +31,13 @@ namespace ki::par {
 
     // Emit an error that describes an expectation failure:
     // Encountered `error_range` where `description` was expected.
-    [[noreturn]] void error_expected(Context& ctx, lsp::Range range, std::string_view description);
+    // Only the first error in a definition is emitted. Sets `ctx.has_error`.
+    void error_expected(Context& ctx, lsp::Range range, std::string_view description);
 
     // Emit an error that describes an expectation failure:
     // Encountered the current token where `description` was expected.
-    [[noreturn]] void error_expected(Context& ctx, std::string_view description);
+    // Only the first error in a definition is emitted. Sets `ctx.has_error`.
+    void error_expected(Context& ctx, std::string_view description);
 
     // Create an identifier from a token.
     [[nodiscard]] auto identifier(Context& ctx, lex::Token const& token) -> utl::String_id;
@@ -72,6 +75,40 @@ namespace ki::par {
     auto parse_type_root(Context& ctx) -> std::optional<cst::Type_id>;
     auto parse_type(Context& ctx) -> std::optional<cst::Type_id>;
 
+    // Placeholders stand in for nodes that could not be parsed after a syntax error. They only
+    // appear in definitions that are discarded, so their contents do not matter.
+    auto placeholder(Context& ctx, std::type_identity<db::Name>) -> db::Name;
+    auto placeholder(Context& ctx, std::type_identity<cst::Expression_id>) -> cst::Expression_id;
+    auto placeholder(Context& ctx, std::type_identity<cst::Type_id>) -> cst::Type_id;
+    auto placeholder(Context& ctx, std::type_identity<cst::Pattern_id>) -> cst::Pattern_id;
+    auto placeholder(Context& ctx, std::type_identity<cst::Type_annotation>)
+        -> cst::Type_annotation;
+    auto placeholder(Context& ctx, std::type_identity<cst::Mutability>) -> cst::Mutability;
+    auto placeholder(Context& ctx, std::type_identity<cst::Path>) -> cst::Path;
+
+    template <typename T>
+    auto placeholder(Context&, std::type_identity<cst::Separated<T>>) -> cst::Separated<T>
+    {
+        return {};
+    }
+
+    template <typename T>
+    auto placeholder(Context&, std::type_identity<std::vector<T>>) -> std::vector<T>
+    {
+        return {};
+    }
+
+    template <typename T>
+    auto placeholder(Context& ctx, std::type_identity<cst::Surrounded<T>>) -> cst::Surrounded<T>
+    {
+        auto const range = peek(ctx).range;
+        return cst::Surrounded<T> {
+            .value       = placeholder(ctx, std::type_identity<T> {}),
+            .open_token  = range,
+            .close_token = range,
+        };
+    }
+
     template <std::invocable<Context&> auto extract>
     auto pretend_parse(Context& ctx) -> std::optional<decltype(extract(ctx))>
     {
@@ -82,10 +119,12 @@ namespace ki::par {
     auto require(Context& ctx, std::string_view const description)
         -> decltype(parser(ctx))::value_type
     {
+        using Result = decltype(parser(ctx))::value_type;
         if (auto result = parser(ctx)) {
             return std::move(result).value();
         }
         error_expected(ctx, description);
+        return placeholder(ctx, std::type_identity<Result> {});
     }
 
     template <std::invocable<Context&> auto parser, utl::Metastring description>
@@ -138,7 +177,13 @@ namespace ki::par {
             while (auto const separator = try_extract(ctx, separator_type)) {
                 add_punctuation(ctx, separator.value().range);
                 sequence.separator_tokens.push_back(separator.value().range);
-                sequence.elements.push_back(require<parser>(ctx, description.view()));
+                if (auto element = parser(ctx)) {
+                    sequence.elements.push_back(std::move(element).value());
+                }
+                else {
+                    error_expected(ctx, description.view());
+                    break;
+                }
             }
         }
         return sequence;
@@ -179,6 +224,7 @@ namespace ki::par {
             return name.value();
         }
         error_expected(ctx, description);
+        return Name { placeholder(ctx, std::type_identity<db::Name> {}) };
     }
 
     constexpr auto parse_lower_name   = parse_name<lex::Type::Lower_name, db::Lower>;
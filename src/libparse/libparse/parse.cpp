@@ -117,6 +117,11 @@ namespace {
             };
         }
         error_expected(ctx, "'mut' or a type");
+        return cst::Template_value_parameter {
+            .name             = name,
+            .type_annotation  = placeholder(ctx, std::type_identity<cst::Type_annotation> {}),
+            .default_argument = std::nullopt,
+        };
     }
 
     auto extract_template_type_parameter(Context& ctx, db::Upper const name)
@@ -173,9 +178,11 @@ namespace {
     }
 } // namespace
 
-auto ki::par::Failure::what() const noexcept -> char const*
+void ki::par::prelex(Context& ctx)
 {
-    return "ki::par::Failure";
+    cpputil::always_assert(not ctx.next_token.has_value());
+    ctx.token_buffer = lex::lex_all(ctx.lex_state);
+    ctx.token_index  = 0;
 }
 
 auto ki::par::is_finished(Context& ctx) -> bool
@@ -185,17 +192,44 @@ auto ki::par::is_finished(Context& ctx) -> bool
 
 auto ki::par::peek(Context& ctx) -> lex::Token
 {
+    if (ctx.has_error) {
+        return lex::Token {
+            .type  = lex::Type::End_of_input,
+            .range = lsp::to_range(ctx.previous_token_end.value_or(lsp::Position {})),
+            .view  = utl::View { .offset = ctx.previous_token_end_offset, .length = 0 },
+        };
+    }
     if (not ctx.next_token.has_value()) {
-        ctx.next_token = lex::next(ctx.lex_state);
+        ctx.next_token = ctx.token_buffer.has_value()
+                           ? lex::token(ctx.token_buffer.value(), ctx.token_index)
+                           : lex::next(ctx.lex_state);
     }
     return ctx.next_token.value();
 }
 
+auto ki::par::peek(Context& ctx, std::size_t const distance) -> lex::Token
+{
+    cpputil::always_assert(ctx.token_buffer.has_value());
+    if (distance == 0 or ctx.has_error) {
+        return peek(ctx);
+    }
+    // The end-of-input token is the last one, and it is repeated indefinitely.
+    auto const& buffer = ctx.token_buffer.value();
+    return lex::token(buffer, std::min(ctx.token_index + distance, buffer.types.size() - 1));
+}
+
 auto ki::par::extract(Context& ctx) -> lex::Token
 {
     auto token = peek(ctx);
+    if (ctx.has_error) {
+        return token; // Keep the real current token for recovery.
+    }
     ctx.next_token.reset();
-    ctx.previous_token_end = token.range.stop;
+    if (ctx.token_buffer.has_value()) {
+        ctx.token_index = std::min(ctx.token_index + 1, ctx.token_buffer.value().types.size() - 1);
+    }
+    ctx.previous_token_end        = token.range.stop;
+    ctx.previous_token_end_offset = token.view.offset + token.view.length;
     return token;
 }
 
@@ -210,14 +244,18 @@ auto ki::par::require_extract(Context& ctx, lex::Type type) -> lex::Token
         return token.value();
     }
     error_expected(ctx, token_description(type));
+    auto const current = peek(ctx);
+    return lex::Token { .type = type, .range = current.range, .view = current.view };
 }
 
 void ki::par::error_expected(Context& ctx, lsp::Range range, std::string_view description)
 {
-    auto found   = token_description(peek(ctx).type);
-    auto message = std::format("Expected {}, but found {}", description, found);
-    ctx.add_diagnostic(lsp::error(range, std::move(message)));
-    throw Failure {};
+    if (not ctx.has_error) {
+        auto found   = token_description(peek(ctx).type);
+        auto message = std::format("Expected {}, but found {}", description, found);
+        ctx.add_diagnostic(lsp::error(range, std::move(message)));
+        ctx.has_error = true;
+    }
 }
 
 void ki::par::error_expected(Context& ctx, std::string_view description)
@@ -225,6 +263,62 @@ void ki::par::error_expected(Context& ctx, std::string_view description)
     error_expected(ctx, peek(ctx).range, description);
 }
 
+auto ki::par::placeholder(Context& ctx, std::type_identity<db::Name>) -> db::Name
+{
+    return name(ctx, peek(ctx));
+}
+
+auto ki::par::placeholder(Context& ctx, std::type_identity<cst::Expression_id>)
+    -> cst::Expression_id
+{
+    return ctx.arena.expressions.push(db::Error {}, peek(ctx).range);
+}
+
+auto ki::par::placeholder(Context& ctx, std::type_identity<cst::Type_id>) -> cst::Type_id
+{
+    auto const range = peek(ctx).range;
+    return ctx.arena.types.push(cst::Wildcard { range }, range);
+}
+
+auto ki::par::placeholder(Context& ctx, std::type_identity<cst::Pattern_id>) -> cst::Pattern_id
+{
+    auto const range = peek(ctx).range;
+    return ctx.arena.patterns.push(cst::Wildcard { range }, range);
+}
+
+auto ki::par::placeholder(Context& ctx, std::type_identity<cst::Type_annotation>)
+    -> cst::Type_annotation
+{
+    return cst::Type_annotation {
+        .type        = placeholder(ctx, std::type_identity<cst::Type_id> {}),
+        .colon_token = peek(ctx).range,
+    };
+}
+
+auto ki::par::placeholder(Context& ctx, std::type_identity<cst::Mutability>) -> cst::Mutability
+{
+    auto const range = peek(ctx).range;
+    return cst::Mutability {
+        .variant       = db::Mutability::Immut,
+        .range         = range,
+        .keyword_token = range,
+    };
+}
+
+auto ki::par::placeholder(Context& ctx, std::type_identity<cst::Path>) -> cst::Path
+{
+    auto segment = cst::Path_segment {
+        .template_arguments         = std::nullopt,
+        .name                       = placeholder(ctx, std::type_identity<db::Name> {}),
+        .leading_double_colon_token = std::nullopt,
+    };
+    return cst::Path {
+        .root     = cst::Path_root {},
+        .segments = utl::to_vector({ std::move(segment) }),
+        .range    = peek(ctx).range,
+    };
+}
+
 auto ki::par::up_to_current(Context& ctx, lsp::Range range) -> lsp::Range
 {
     cpputil::always_assert(ctx.previous_token_end.has_value());
@@ -233,7 +327,8 @@ auto ki::par::up_to_current(Context& ctx, lsp::Range range) -> lsp::Range
 
 void ki::par::add_semantic_token(Context& ctx, lsp::Range range, Semantic type)
 {
-    if (ctx.db.config.semantic_tokens == db::Semantic_token_mode::Full) {
+    // After a syntax error, the remaining tokens of the definition are placeholders.
+    if (ctx.db.config.semantic_tokens == db::Semantic_token_mode::Full and not ctx.has_error) {
         cpputil::always_assert(not lsp::is_multiline(range));
         cpputil::always_assert(range.start.column < range.stop.column);
         ctx.semantic_tokens.push_back(
@@ -257,7 +352,7 @@ void ki::par::add_punctuation(Context& ctx, lsp::Range range)
 
 void ki::par::set_previous_path_head_semantic_type(Context& ctx, Semantic const type)
 {
-    if (ctx.db.config.semantic_tokens == db::Semantic_token_mode::Full) {
+    if (ctx.db.config.semantic_tokens == db::Semantic_token_mode::Full and not ctx.has_error) {
         ctx.semantic_tokens.at(ctx.previous_path_semantic_offset).type = type;
     }
 }
@@ -311,14 +406,19 @@ auto ki::par::parse_boolean(Context& ctx, lex::Token const& literal) -> std::opt
 
 auto ki::par::context(db::Database& db, db::Document_id doc_id, db::Diagnostic_sink sink) -> Context
 {
+    auto const& document = db.documents[doc_id];
     return Context {
         .db                            = db,
         .doc_id                        = doc_id,
         .add_diagnostic                = sink,
         .arena                         = cst::Arena {},
-        .lex_state                     = lex::state(db.documents[doc_id].text),
+        .lex_state                     = lex::state(document.text, document.line_starts),
+        .token_buffer                  = std::nullopt,
+        .token_index                   = 0,
         .next_token                    = std::nullopt,
         .previous_token_end            = std::nullopt,
+        .previous_token_end_offset     = 0,
+        .definition_view               = {},
         .semantic_tokens               = {},
         .previous_path_semantic_offset = {},
         .plus_id                       = db.string_pool.make("+"sv),
@@ -535,6 +635,7 @@ auto ki::par::extract_path(Context& ctx, cst::Path_root const root) -> cst::Path
     }
     if (segments.empty()) {
         error_expected(ctx, "at least one path segment");
+        segments = std::move(placeholder(ctx, std::type_identity<cst::Path> {}).segments);
     }
 
     ctx.previous_path_semantic_offset = head_semantic_token_offset;
@@ -6,21 +6,22 @@
 
 namespace ki::par {
 
-    struct Failure : std::exception {
-        [[nodiscard]] auto what() const noexcept -> char const* override;
-    };
-
     struct Context {
         db::Database&                    db;
         db::Document_id                  doc_id;
         db::Diagnostic_sink              add_diagnostic;
         cst::Arena                       arena;
         lex::State                       lex_state;
+        std::optional<lex::Token_buffer> token_buffer; // When set, tokens are read from here.
+        std::size_t                      token_index {}; // Index of the current token.
         std::optional<lex::Token>        next_token;
         std::optional<lsp::Position>     previous_token_end;
+        std::uint32_t                    previous_token_end_offset {};
+        utl::View                        definition_view; // Bytes of the last parsed definition.
         std::vector<lsp::Semantic_token> semantic_tokens;
         std::size_t                      previous_path_semantic_offset {};
         std::size_t                      block_depth {};
+        bool                             has_error {}; // Set by a syntax error in a definition.
         utl::String_id                   plus_id;
         utl::String_id                   asterisk_id;
     };
@@ -29,12 +30,20 @@ namespace ki::par {
     [[nodiscard]] auto context(db::Database& db, db::Document_id doc_id, db::Diagnostic_sink sink)
         -> Context;
 
+    // Lex the rest of the document up front, so that tokens are read from a buffer.
+    void prelex(Context& ctx);
+
     // Check whether the current token is the end-of-input token.
     [[nodiscard]] auto is_finished(Context& ctx) -> bool;
 
-    // Inspect the current token without consuming it.
+    // Inspect the current token without consuming it. After a syntax error, this is an
+    // end-of-input token until the parse loop resets `has_error`.
     [[nodiscard]] auto peek(Context& ctx) -> lex::Token;
 
+    // Inspect the token `distance` tokens after the current one without consuming anything.
+    // Requires a token buffer. After a syntax error, this is the same token as `peek(ctx)`.
+    [[nodiscard]] auto peek(Context& ctx, std::size_t distance) -> lex::Token;
+
     // Consume the current token.
     [[nodiscard]] auto extract(Context& ctx) -> lex::Token;
 
@@ -44,7 +53,7 @@ namespace ki::par {
     // Ensure module and impl blocks have been closed correctly.
     void handle_end_of_input(Context& ctx, lex::Token const& end);
 
-    // Handle an unexpected token where a definition was expected.
+    // Report an unexpected token where a definition was expected, and skip to a recovery point.
     void handle_bad_token(Context& ctx, lex::Token const& token);
 
     auto extract_function(Context& ctx, lex::Token const& fn_keyword) -> cst::Function;
@@ -54,31 +63,61 @@ namespace ki::par {
     auto extract_alias(Context& ctx, lex::Token const& alias_keyword) -> cst::Alias;
     auto extract_implementation(Context& ctx, lex::Token const& impl_keyword) -> cst::Impl_begin;
     auto extract_submodule(Context& ctx, lex::Token const& module_keyword) -> cst::Submodule_begin;
-    auto extract_block_end(Context& ctx, lex::Token const& brace_close) -> cst::Block_end;
+    auto parse_block_end(Context& ctx, lex::Token const& brace_close)
+        -> std::optional<cst::Block_end>;
 
-    void parse(Context& ctx, auto&& visitor)
+    // Parse definitions until the end of input, or until `stop` returns true for the next token.
+    // Errors between definitions are recovered from in place. The first error within a definition
+    // sets the sticky `has_error` flag, after which the parsers see no more tokens and finish the
+    // definition with placeholders. The definition is then discarded, and the loop skips to the
+    // next recovery point.
+    void parse(Context& ctx, auto&& visitor, std::predicate<lex::Token const&> auto const& stop)
     {
         for (;;) {
-            try {
-                switch (auto token = extract(ctx); token.type) {
-                case lex::Type::Fn:           visitor(extract_function(ctx, token)); break;
-                case lex::Type::Struct:       visitor(extract_structure(ctx, token)); break;
-                case lex::Type::Enum:         visitor(extract_enumeration(ctx, token)); break;
-                case lex::Type::Concept:      visitor(extract_concept(ctx, token)); break;
-                case lex::Type::Alias:        visitor(extract_alias(ctx, token)); break;
-                case lex::Type::Impl:         visitor(extract_implementation(ctx, token)); break;
-                case lex::Type::Module:       visitor(extract_submodule(ctx, token)); break;
-                case lex::Type::Brace_close:  visitor(extract_block_end(ctx, token)); break;
-                case lex::Type::End_of_input: handle_end_of_input(ctx, token); return;
-                default:                      handle_bad_token(ctx, token); break;
-                }
+            db::check_cancellation(ctx.db.cancellation);
+            if (stop(peek(ctx))) {
+                return;
             }
-            catch (Failure const&) {
-                skip_to_next_recovery_point(ctx);
+            auto const token = extract(ctx);
+
+            // Record the bytes spanned by the definition before passing it to the visitor.
+            auto const emit = [&](auto definition) {
+                if (std::exchange(ctx.has_error, false)) {
+                    skip_to_next_recovery_point(ctx);
+                    return;
+                }
+                ctx.definition_view = utl::View {
+                    .offset = token.view.offset,
+                    .length = ctx.previous_token_end_offset - token.view.offset,
+                };
+                visitor(std::move(definition));
+            };
+
+            switch (token.type) {
+            case lex::Type::Fn:           emit(extract_function(ctx, token)); break;
+            case lex::Type::Struct:       emit(extract_structure(ctx, token)); break;
+            case lex::Type::Enum:         emit(extract_enumeration(ctx, token)); break;
+            case lex::Type::Concept:      emit(extract_concept(ctx, token)); break;
+            case lex::Type::Alias:        emit(extract_alias(ctx, token)); break;
+            case lex::Type::Impl:         emit(extract_implementation(ctx, token)); break;
+            case lex::Type::Module:       emit(extract_submodule(ctx, token)); break;
+            case lex::Type::Brace_close:
+                if (auto end = parse_block_end(ctx, token)) {
+                    emit(end.value());
+                }
+                break;
+            case lex::Type::End_of_input: handle_end_of_input(ctx, token); return;
+            default:                      handle_bad_token(ctx, token); break;
             }
         }
     }
 
+    // Parse definitions until the end of input.
+    void parse(Context& ctx, auto&& visitor)
+    {
+        parse(ctx, visitor, [](lex::Token const&) { return false; });
+    }
+
 } // namespace ki::par
 
 #endif // KIELI_LIBPARSE_PARSE
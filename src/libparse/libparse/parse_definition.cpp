@@ -17,6 +17,7 @@ namespace {
 
         if (not function_parameters.has_value()) {
             error_expected(ctx, "a '(' followed by a function parameter list");
+            function_parameters = placeholder(ctx, std::type_identity<cst::Function_parameters> {});
         }
 
         return cst::Function_signature {
@@ -101,7 +102,7 @@ auto ki::par::extract_function(Context& ctx, lex::Token const& fn_keyword) -> cs
         add_semantic_token(ctx, equals_sign.value().range, Semantic::Operator_name);
     }
 
-    auto const function_body
+    auto function_body
         = equals_sign.has_value() ? parse_expression(ctx) : parse_block_expression(ctx);
 
     if (not function_body.has_value()) {
@@ -109,6 +110,7 @@ auto ki::par::extract_function(Context& ctx, lex::Token const& fn_keyword) -> cs
             ctx,
             equals_sign.has_value() ? "the function body expression"
                                     : "the function body: '=' or '{'");
+        function_body = placeholder(ctx, std::type_identity<cst::Expression_id> {});
     }
 
     return cst::Function {
@@ -216,7 +218,9 @@ auto ki::par::extract_implementation(Context& ctx, lex::Token const& impl_keywor
     add_keyword(ctx, impl_keyword.range);
     auto const self_type  = require<parse_type>(ctx, "the Self type");
     auto const open_brace = require_extract(ctx, lex::Type::Brace_open);
-    ++ctx.block_depth;
+    if (not ctx.has_error) {
+        ++ctx.block_depth;
+    }
     return cst::Impl_begin {
         .template_parameters = parse_template_parameters(ctx),
         .self_type           = self_type,
@@ -233,7 +237,9 @@ auto ki::par::extract_submodule(Context& ctx, lex::Token const& module_keyword)
     auto const name = extract_lower_name(ctx, "a module name");
     add_semantic_token(ctx, name.range, Semantic::Module);
     auto const open_brace = require_extract(ctx, lex::Type::Brace_open);
-    ++ctx.block_depth;
+    if (not ctx.has_error) {
+        ++ctx.block_depth;
+    }
     return cst::Submodule_begin {
         .name             = name,
         .module_token     = module_keyword.range,
@@ -242,11 +248,13 @@ auto ki::par::extract_submodule(Context& ctx, lex::Token const& module_keyword)
     };
 }
 
-auto ki::par::extract_block_end(Context& ctx, lex::Token const& brace_close) -> cst::Block_end
+auto ki::par::parse_block_end(Context& ctx, lex::Token const& brace_close)
+    -> std::optional<cst::Block_end>
 {
     if (ctx.block_depth == 0) {
         ctx.add_diagnostic(lsp::error(brace_close.range, "Unexpected closing brace"));
-        throw Failure {};
+        skip_to_next_recovery_point(ctx);
+        return std::nullopt;
     }
     --ctx.block_depth;
     return cst::Block_end { .range = brace_close.range };
@@ -270,5 +278,4 @@ void ki::par::handle_bad_token(Context& ctx, lex::Token const& token)
         = std::format("Expected a definition, but found {}", lex::token_description(token.type));
     ctx.add_diagnostic(lsp::error(token.range, std::move(message)));
     skip_to_next_recovery_point(ctx);
-    throw Failure {};
 }
@@ -108,6 +108,7 @@ namespace {
         else {
             error_expected(ctx, "a ',' or a ']'");
         }
+        return db::Error {};
     }
 
     auto extract_conditional(Context& ctx, lex::Token const& if_keyword) -> cst::Expression_variant
@@ -435,6 +436,7 @@ namespace {
             return db::Error {};
         }
         error_expected(ctx, "a struct member name, a tuple member index, or an array index");
+        return db::Error {};
     }
 
     auto parse_potential_member_access(Context& ctx) -> std::optional<cst::Expression_id>
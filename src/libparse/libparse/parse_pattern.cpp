@@ -36,6 +36,7 @@ namespace {
         }
         error_expected(
             ctx, patterns.elements.empty() ? "a slice element pattern or a ']'" : "a ',' or a ']'");
+        return cst::Wildcard { peek(ctx).range };
     };
 
     auto parse_field_pattern(Context& ctx) -> std::optional<cst::patt::Field>
@@ -11,8 +11,11 @@ namespace {
         db::Database&                   db;
         Context&                        ctx;
         des::Context&                   des_ctx;
+        par::Context const&             par_ctx;
         std::vector<db::Environment_id> env_id_stack;
         std::vector<db::Symbol_id>      symbol_order;
+        std::vector<Definition>         definitions;
+        std::size_t                     block_depth {};
 
         auto env_id() const -> db::Environment_id
         {
@@ -20,9 +23,18 @@ namespace {
             return env_id_stack.back();
         }
 
-        void bind(db::Name name, db::Symbol_variant variant)
+        void bind(lsp::Range range, db::Name name, db::Symbol_variant variant)
         {
-            symbol_order.push_back(bind_symbol(db, ctx, env_id(), name, variant));
+            auto const symbol_id = bind_symbol(db, ctx, env_id(), name, variant);
+            symbol_order.push_back(symbol_id);
+            definitions.push_back(
+                Definition {
+                    .range            = range,
+                    .view             = par_ctx.definition_view,
+                    .symbol_id        = symbol_id,
+                    .block_depth      = block_depth,
+                    .interface_length = par_ctx.definition_view.length,
+                });
         }
 
         void operator()(cst::Function const& cst)
@@ -40,7 +52,10 @@ namespace {
                     .name      = name,
                 });
 
-            bind(name, fun_id);
+            bind(cst.range, name, fun_id);
+
+            definitions.back().interface_length = signature_length(
+                des_ctx.cst, par_ctx.lex_state.text, par_ctx.definition_view, cst);
         }
 
         void operator()(cst::Struct const& cst)
@@ -61,7 +76,7 @@ namespace {
 
             ctx.arena.hir.types[type_id] = hir::type::Structure { .name = name, .id = struct_id };
 
-            bind(name, struct_id);
+            bind(cst.range, name, struct_id);
         }
 
         void operator()(cst::Enum const& cst)
@@ -82,7 +97,7 @@ namespace {
 
             ctx.arena.hir.types[type_id] = hir::type::Enumeration { .name = name, .id = enum_id };
 
-            bind(name, enum_id);
+            bind(cst.range, name, enum_id);
         }
 
         void operator()(cst::Alias const& cst)
@@ -99,7 +114,7 @@ namespace {
                     .name   = name,
                 });
 
-            bind(name, alias_id);
+            bind(cst.range, name, alias_id);
         }
 
         void operator()(cst::Concept const& cst)
@@ -116,12 +131,20 @@ namespace {
                     .name   = name,
                 });
 
-            bind(name, concept_id);
+            bind(cst.range, name, concept_id);
         }
 
         void operator()(cst::Impl_begin const& impl)
         {
             ctx.add_diagnostic(lsp::error(impl.impl_token, "impl blocks are not supported yet"));
+            definitions.push_back(
+                Definition {
+                    .range            = impl.range,
+                    .view             = par_ctx.definition_view,
+                    .symbol_id        = std::nullopt,
+                    .block_depth      = ++block_depth,
+                    .interface_length = par_ctx.definition_view.length,
+                });
         }
 
         void operator()(cst::Submodule_begin const& module)
@@ -143,40 +166,84 @@ namespace {
                     .name       = module.name,
                 });
 
-            bind(module.name, module_id);
+            ++block_depth;
+            bind(module.range, module.name, module_id);
 
             env_id_stack.push_back(child_env_id);
         }
 
-        void operator()(cst::Block_end const&)
+        void operator()(cst::Block_end const& end)
         {
             cpputil::always_assert(not env_id_stack.empty());
             env_id_stack.pop_back();
+            definitions.push_back(
+                Definition {
+                    .range            = end.range,
+                    .view             = par_ctx.definition_view,
+                    .symbol_id        = std::nullopt,
+                    .block_depth      = --block_depth,
+                    .interface_length = par_ctx.definition_view.length,
+                });
         }
     };
 } // namespace
 
+auto ki::res::signature_length(
+    cst::Arena const&    arena,
+    std::string_view     text,
+    utl::View            view,
+    cst::Function const& function) -> std::uint32_t
+{
+    auto const start = function.range.start;
+    auto const body  = arena.expressions[function.body].range.start;
+
+    // The position of the body relative to the start of the function.
+    auto const stop = body.line == start.line
+                        ? lsp::Position { .line = 0, .column = body.column - start.column }
+                        : lsp::Position { .line = body.line - start.line, .column = body.column };
+
+    auto const signature = db::text_range(view.string(text), lsp::Range(lsp::Position {}, stop));
+    return cpputil::num::safe_cast<std::uint32_t>(signature.size());
+}
+
+auto ki::res::interface_hash(std::string_view text, Definition const& definition) -> std::size_t
+{
+    return std::hash<std::string_view> {}(
+        definition.view.string(text).substr(0, definition.interface_length));
+}
+
 auto ki::res::collect_document(db::Database& db, Context& ctx) -> std::vector<db::Symbol_id>
 {
+    db::check_cancellation(db.cancellation);
+
     auto par_ctx = par::context(db, ctx.doc_id, ctx.add_diagnostic);
 
     auto des_ctx = des::Context {
         .cst            = par_ctx.arena,
         .ast            = ast::Arena {},
         .add_diagnostic = ctx.add_diagnostic,
+        .cancellation   = db.cancellation,
     };
 
     auto collector = Collector {
         .db           = db,
         .ctx          = ctx,
         .des_ctx      = des_ctx,
+        .par_ctx      = par_ctx,
         .env_id_stack = { ctx.root_env_id },
         .symbol_order = {},
+        .definitions  = {},
+        .block_depth  = 0,
     };
 
     par::parse(par_ctx, collector);
 
-    ctx.arena.ast = std::move(des_ctx.ast);
+    ctx.arena.ast   = std::move(des_ctx.ast);
+    ctx.definitions = std::move(collector.definitions);
+
+    for (Definition& definition : ctx.definitions) {
+        definition.interface_hash = interface_hash(par_ctx.lex_state.text, definition);
+    }
 
     if (db.config.semantic_tokens == db::Semantic_token_mode::Full) {
         db.documents[ctx.doc_id].info.semantic_tokens = std::move(par_ctx.semantic_tokens);
@@ -0,0 +1,592 @@
+#include <libutl/utilities.hpp>
+#include <libparse/parse.hpp>
+#include <libdesugar/desugar.hpp>
+#include <libresolve/resolve.hpp>
+
+using namespace ki;
+using namespace ki::res;
+
+namespace {
+    using Parsed_definition = std::variant<
+        cst::Function,
+        cst::Struct,
+        cst::Enum,
+        cst::Alias,
+        cst::Concept,
+        cst::Impl_begin,
+        cst::Submodule_begin,
+        cst::Block_end>;
+
+    // A definition that was parsed again. If its interface changed, every query that depends on
+    // it must be recomputed. Otherwise, only its own queries are recomputed.
+    struct Change {
+        std::size_t index {};
+        bool        is_interface_changed {};
+    };
+
+    struct Recollected {
+        db::Name      name;
+        lsp::Range    range;
+        std::uint32_t interface_length {};
+    };
+
+    constexpr auto end_of_document = lsp::Position {
+        .line   = std::numeric_limits<std::uint32_t>::max(),
+        .column = std::numeric_limits<std::uint32_t>::max(),
+    };
+
+    auto end_offset(utl::View view) -> std::uint32_t
+    {
+        return view.offset + view.length;
+    }
+
+    // The queries whose results belong to the definition of a symbol.
+    auto definition_queries(db::Symbol_variant const& variant) -> std::vector<Query>
+    {
+        auto const visitor = utl::Overload {
+            [](hir::Function_id id) -> std::vector<Query> {
+                return {
+                    Query { .kind = Query_kind::Function_signature, .id = id.get() },
+                    Query { .kind = Query_kind::Function_body, .id = id.get() },
+                };
+            },
+            [](hir::Structure_id id) -> std::vector<Query> {
+                return { Query { .kind = Query_kind::Structure, .id = id.get() } };
+            },
+            [](hir::Enumeration_id id) -> std::vector<Query> {
+                return { Query { .kind = Query_kind::Enumeration, .id = id.get() } };
+            },
+            [](hir::Concept_id id) -> std::vector<Query> {
+                return { Query { .kind = Query_kind::Concept, .id = id.get() } };
+            },
+            [](hir::Alias_id id) -> std::vector<Query> {
+                return { Query { .kind = Query_kind::Alias, .id = id.get() } };
+            },
+            [](auto const&) -> std::vector<Query> { return {}; },
+        };
+        return std::visit(visitor, variant);
+    }
+
+    auto is_bound(Context const& ctx, db::Environment_id env_id, db::Name name, db::Symbol_id id)
+        -> bool
+    {
+        auto const& map = ctx.arena.environments[env_id].map;
+        auto const  it  = map.find(name.id);
+        return it != map.end() and it->second == id;
+    }
+
+    // Erase the information that was collected within `region` during the previous analysis.
+    void erase_region_info(db::Document_info& info, lsp::Range const region)
+    {
+        auto const contains = [region](lsp::Position position) {
+            return lsp::range_contains(region, position);
+        };
+        std::erase_if(info.diagnostics, [&](lsp::Diagnostic const& diagnostic) {
+            return contains(diagnostic.range.start);
+        });
+        std::erase_if(info.semantic_tokens, [&](lsp::Semantic_token const& token) {
+            return contains(token.position);
+        });
+        std::erase_if(info.inlay_hints, [&](db::Inlay_hint const& hint) {
+            return contains(hint.position);
+        });
+        std::erase_if(info.references, [&](db::Symbol_reference const& reference) {
+            return contains(reference.reference.range.start);
+        });
+        std::erase_if(info.actions, [&](db::Action const& action) {
+            return contains(action.range.start);
+        });
+    }
+
+    // Erase the unused symbol warnings of top-level definitions. They are reported again after
+    // the document's symbols have been resolved.
+    void erase_unused_definition_warnings(db::Database& db, Context const& ctx)
+    {
+        std::vector<lsp::Range>    name_ranges;
+        std::vector<db::Symbol_id> symbol_ids;
+        for (Definition const& definition : ctx.definitions) {
+            if (definition.symbol_id.has_value()) {
+                name_ranges.push_back(ctx.arena.symbols[definition.symbol_id.value()].name.range);
+                symbol_ids.push_back(definition.symbol_id.value());
+            }
+        }
+        std::ranges::sort(name_ranges);
+        std::ranges::sort(symbol_ids);
+
+        auto& info = db.documents[ctx.doc_id].info;
+        std::erase_if(info.diagnostics, [&](lsp::Diagnostic const& diagnostic) {
+            return diagnostic.tag == lsp::Diagnostic_tag::Unnecessary
+               and std::ranges::binary_search(name_ranges, diagnostic.range);
+        });
+        std::erase_if(info.actions, [&](db::Action const& action) {
+            auto const* silence = std::get_if<db::Action_silence_unused>(&action.variant);
+            return silence != nullptr
+               and std::ranges::binary_search(symbol_ids, silence->symbol_id);
+        });
+    }
+
+    // Replace the AST of the definition identified by `symbol_id` with `parsed`, which spans
+    // `view` in `text`. Returns nullopt if `parsed` does not define the same symbol.
+    auto recollect_definition(
+        Context&                 ctx,
+        des::Context&            des_ctx,
+        std::string_view         text,
+        utl::View                view,
+        db::Symbol_id            symbol_id,
+        Parsed_definition const& parsed) -> std::optional<Recollected>
+    {
+        auto const visitor = utl::Overload {
+            [&](cst::Function const& cst, hir::Function_id id) -> std::optional<Recollected> {
+                auto& info = ctx.arena.hir.functions[id];
+                if (not is_bound(ctx, info.env_id, cst.signature.name, symbol_id)) {
+                    return std::nullopt;
+                }
+                info.ast  = des::desugar(des_ctx, cst);
+                info.name = cst.signature.name;
+                return Recollected {
+                    .name             = cst.signature.name,
+                    .range            = cst.range,
+                    .interface_length = signature_length(des_ctx.cst, text, view, cst),
+                };
+            },
+            [&](cst::Struct const& cst, hir::Structure_id id) -> std::optional<Recollected> {
+                auto& info = ctx.arena.hir.structures[id];
+                auto  name = cst.constructor.name;
+                if (not is_bound(ctx, info.env_id, name, symbol_id)) {
+                    return std::nullopt;
+                }
+                info.ast  = des::desugar(des_ctx, cst);
+                info.name = name;
+
+                ctx.arena.hir.types[info.type_id] = hir::type::Structure { .name = name, .id = id };
+                return Recollected {
+                    .name             = name,
+                    .range            = cst.range,
+                    .interface_length = view.length,
+                };
+            },
+            [&](cst::Enum const& cst, hir::Enumeration_id id) -> std::optional<Recollected> {
+                auto& info = ctx.arena.hir.enumerations[id];
+                if (not is_bound(ctx, info.env_id, cst.name, symbol_id)) {
+                    return std::nullopt;
+                }
+                info.ast  = des::desugar(des_ctx, cst);
+                info.name = cst.name;
+
+                ctx.arena.hir.types[info.type_id]
+                    = hir::type::Enumeration { .name = cst.name, .id = id };
+                return Recollected {
+                    .name             = cst.name,
+                    .range            = cst.range,
+                    .interface_length = view.length,
+                };
+            },
+            [&](cst::Alias const& cst, hir::Alias_id id) -> std::optional<Recollected> {
+                auto& info = ctx.arena.hir.aliases[id];
+                if (not is_bound(ctx, info.env_id, cst.name, symbol_id)) {
+                    return std::nullopt;
+                }
+                info.ast  = des::desugar(des_ctx, cst);
+                info.name = cst.name;
+                return Recollected {
+                    .name             = cst.name,
+                    .range            = cst.range,
+                    .interface_length = view.length,
+                };
+            },
+            [&](cst::Concept const& cst, hir::Concept_id id) -> std::optional<Recollected> {
+                auto& info = ctx.arena.hir.concepts[id];
+                if (not is_bound(ctx, info.env_id, cst.name, symbol_id)) {
+                    return std::nullopt;
+                }
+                info.ast  = des::desugar(des_ctx, cst);
+                info.name = cst.name;
+                return Recollected {
+                    .name             = cst.name,
+                    .range            = cst.range,
+                    .interface_length = view.length,
+                };
+            },
+            [](auto const&, auto const&) -> std::optional<Recollected> { return std::nullopt; },
+        };
+        return std::visit(visitor, parsed, ctx.arena.symbols[symbol_id].variant);
+    }
+
+    // Parse the definitions [first, last) again, starting at `start`, which is at byte
+    // `start_offset`. The region that is parsed extends up to the beginning of the next
+    // definition, and must contain the same definitions. If the definitions were edited, their
+    // interfaces are compared with the interfaces they had before the edit.
+    auto recollect_region(
+        db::Database&        db,
+        Context&             ctx,
+        std::size_t const    first,
+        std::size_t const    last,
+        lsp::Position const  start,
+        std::uint32_t const  start_offset,
+        bool const           is_edited,
+        std::vector<Change>& changes) -> bool
+    {
+        auto const stop = last != ctx.definitions.size() ? ctx.definitions.at(last).range.start
+                                                         : end_of_document;
+
+        auto&            info = db.documents[ctx.doc_id].info;
+        std::string_view text = db.documents[ctx.doc_id].text;
+
+        erase_region_info(info, lsp::Range(start, stop));
+
+        auto par_ctx = par::context(db, ctx.doc_id, ctx.add_diagnostic);
+
+        lex::seek(par_ctx.lex_state, start_offset);
+        par_ctx.block_depth = first != 0 ? ctx.definitions.at(first - 1).block_depth : 0;
+
+        std::vector<Parsed_definition> parsed;
+        std::vector<utl::View>         views;
+        par::parse(
+            par_ctx,
+            [&](auto definition) {
+                parsed.emplace_back(std::move(definition));
+                views.push_back(par_ctx.definition_view);
+            },
+            [&](lex::Token const& token) { return token.range.start >= stop; });
+
+        if (parsed.size() != last - first) {
+            return false;
+        }
+        if (stop != end_of_document and par::peek(par_ctx).range.start != stop) {
+            return false;
+        }
+
+        auto des_ctx = des::Context {
+            .cst            = par_ctx.arena,
+            .ast            = std::move(ctx.arena.ast),
+            .add_diagnostic = ctx.add_diagnostic,
+            .cancellation   = db.cancellation,
+        };
+
+        auto const recollect = [&] {
+            for (std::size_t index = first; index != last; ++index) {
+                Definition& definition = ctx.definitions.at(index);
+                if (not definition.symbol_id.has_value()) {
+                    return false;
+                }
+
+                auto const symbol_id   = definition.symbol_id.value();
+                auto const view        = views.at(index - first);
+                auto const recollected = recollect_definition(
+                    ctx, des_ctx, text, view, symbol_id, parsed.at(index - first));
+                if (not recollected.has_value()) {
+                    return false;
+                }
+
+                auto const [name, range, interface_length] = recollected.value();
+                auto const old_interface_hash               = definition.interface_hash;
+
+                definition.range                  = range;
+                definition.view                   = view;
+                definition.interface_length       = interface_length;
+                definition.interface_hash         = interface_hash(text, definition);
+                ctx.arena.symbols[symbol_id].name = name;
+
+                bool const is_interface_changed
+                    = is_edited and definition.interface_hash != old_interface_hash;
+
+                db::add_reference(db, ctx.doc_id, lsp::write(name.range), symbol_id);
+
+                changes.push_back(
+                    Change { .index = index, .is_interface_changed = is_interface_changed });
+            }
+            return true;
+        };
+
+        bool is_recollected = false;
+        try {
+            is_recollected = recollect();
+        }
+        catch (...) {
+            ctx.arena.ast = std::move(des_ctx.ast);
+            throw;
+        }
+        ctx.arena.ast = std::move(des_ctx.ast);
+
+        if (is_recollected and db.config.semantic_tokens == db::Semantic_token_mode::Full) {
+            auto& tokens = info.semantic_tokens;
+            auto  it = std::ranges::lower_bound(tokens, start, {}, &lsp::Semantic_token::position);
+            tokens.insert(it, par_ctx.semantic_tokens.begin(), par_ctx.semantic_tokens.end());
+        }
+        return is_recollected;
+    }
+
+    // Find the definitions that are not in `changes`, but have a query that transitively depends
+    // on a changed interface.
+    auto find_dependents(Context const& ctx, std::vector<Change> const& changes)
+        -> std::vector<std::size_t>
+    {
+        std::map<Query, std::size_t> owners;
+        for (std::size_t index = 0; index != ctx.definitions.size(); ++index) {
+            if (auto const symbol_id = ctx.definitions.at(index).symbol_id) {
+                auto const& variant = ctx.arena.symbols[symbol_id.value()].variant;
+                for (Query query : definition_queries(variant)) {
+                    owners.insert_or_assign(query, index);
+                }
+            }
+        }
+
+        std::map<Query, std::vector<Query>> dependents;
+        for (auto const& [query, record] : ctx.queries) {
+            for (Query dependency : record.dependencies) {
+                dependents[dependency].push_back(query);
+            }
+        }
+
+        std::vector<bool>        is_invalidated(ctx.definitions.size());
+        std::vector<Query>       worklist;
+        std::vector<std::size_t> result;
+
+        for (Change const& change : changes) {
+            is_invalidated.at(change.index) = true;
+            if (change.is_interface_changed) {
+                auto const symbol_id = ctx.definitions.at(change.index).symbol_id.value();
+                std::ranges::copy(
+                    definition_queries(ctx.arena.symbols[symbol_id].variant),
+                    std::back_inserter(worklist));
+            }
+        }
+
+        std::vector<Query> visited = worklist;
+        while (not worklist.empty()) {
+            auto const query = worklist.back();
+            worklist.pop_back();
+
+            auto const it = dependents.find(query);
+            if (it == dependents.end()) {
+                continue;
+            }
+            for (Query const dependent : it->second) {
+                auto const owner = owners.find(dependent);
+                cpputil::always_assert(owner != owners.end());
+
+                if (not is_invalidated.at(owner->second)) {
+                    is_invalidated.at(owner->second) = true;
+                    result.push_back(owner->second);
+                }
+                // Nothing depends on function bodies, and the interface of every other query
+                // that depends on a changed interface may have changed as well.
+                if (dependent.kind != Query_kind::Function_body
+                    and not std::ranges::contains(visited, dependent)) {
+                    visited.push_back(dependent);
+                    worklist.push_back(dependent);
+                }
+            }
+        }
+
+        std::ranges::sort(result);
+        return result;
+    }
+
+    // Discard the cached results of the queries that belong to the definition of `symbol_id`, and
+    // retract the uses that were recorded while computing them.
+    void reset_definition(Context& ctx, db::Symbol_id symbol_id)
+    {
+        auto const& variant = ctx.arena.symbols[symbol_id].variant;
+
+        for (Query const query : definition_queries(variant)) {
+            if (auto node = ctx.queries.extract(query)) {
+                for (db::Symbol_id used_id : node.mapped().uses) {
+                    --ctx.arena.symbols[used_id].use_count;
+                }
+            }
+        }
+
+        auto const visitor = utl::Overload {
+            [&](hir::Function_id id) {
+                ctx.arena.hir.functions[id].signature = std::nullopt;
+                ctx.arena.hir.functions[id].body_id   = std::nullopt;
+                ctx.signature_scope_map.erase(id);
+            },
+            [&](hir::Structure_id id) { ctx.arena.hir.structures[id].hir = std::nullopt; },
+            [&](hir::Enumeration_id id) { ctx.arena.hir.enumerations[id].hir = std::nullopt; },
+            [&](hir::Concept_id id) { ctx.arena.hir.concepts[id].hir = std::nullopt; },
+            [&](hir::Alias_id id) { ctx.arena.hir.aliases[id].hir = std::nullopt; },
+            [](auto const&) {},
+        };
+        std::visit(visitor, variant);
+    }
+
+    // Moves the positions and byte offsets that follow an edit.
+    struct Shift {
+        lsp::Position from; // Positions before `from` precede the edit and are not moved.
+        std::int64_t  lines {};
+        std::int64_t  bytes {};
+    };
+
+    void apply_shift(Shift const& shift, lsp::Position& position)
+    {
+        if (position >= shift.from) {
+            position.line = cpputil::num::safe_cast<std::uint32_t>(position.line + shift.lines);
+        }
+    }
+
+    void apply_shift(Shift const& shift, lsp::Range& range)
+    {
+        apply_shift(shift, range.start);
+        apply_shift(shift, range.stop);
+    }
+
+    // Move the information that was collected after an edit into place, starting with the
+    // definition at `first`. The AST and HIR nodes of the definitions are not moved, because a
+    // definition is always parsed again before it is resolved again.
+    void shift_document(db::Database& db, Context& ctx, std::size_t const first, Shift const& shift)
+    {
+        for (Definition& definition : ctx.definitions | std::views::drop(first)) {
+            apply_shift(shift, definition.range);
+            definition.view.offset
+                = cpputil::num::safe_cast<std::uint32_t>(definition.view.offset + shift.bytes);
+        }
+
+        auto& info = db.documents[ctx.doc_id].info;
+        for (lsp::Diagnostic& diagnostic : info.diagnostics) {
+            apply_shift(shift, diagnostic.range);
+            for (lsp::Diagnostic_related& related : diagnostic.related_info) {
+                if (related.location.doc_id == ctx.doc_id) {
+                    apply_shift(shift, related.location.range);
+                }
+            }
+        }
+        for (lsp::Semantic_token& token : info.semantic_tokens) {
+            apply_shift(shift, token.position);
+        }
+        for (db::Inlay_hint& hint : info.inlay_hints) {
+            apply_shift(shift, hint.position);
+        }
+        for (db::Symbol_reference& reference : info.references) {
+            apply_shift(shift, reference.reference.range);
+        }
+        for (db::Action& action : info.actions) {
+            apply_shift(shift, action.range);
+            if (auto* fill = std::get_if<db::Action_fill_in_struct_init>(&action.variant)) {
+                if (fill->final_field_end.has_value()) {
+                    apply_shift(shift, fill->final_field_end.value());
+                }
+            }
+        }
+
+        for (db::Symbol& symbol : ctx.arena.symbols) {
+            apply_shift(shift, symbol.name.range);
+        }
+
+        auto const shift_names = [&](auto& infos) {
+            for (auto& info : infos) {
+                apply_shift(shift, info.name.range);
+            }
+        };
+        shift_names(ctx.arena.hir.modules);
+        shift_names(ctx.arena.hir.functions);
+        shift_names(ctx.arena.hir.structures);
+        shift_names(ctx.arena.hir.enumerations);
+        shift_names(ctx.arena.hir.constructors);
+        shift_names(ctx.arena.hir.fields);
+        shift_names(ctx.arena.hir.concepts);
+        shift_names(ctx.arena.hir.aliases);
+        shift_names(ctx.arena.hir.local_variables);
+        shift_names(ctx.arena.hir.local_mutabilities);
+        shift_names(ctx.arena.hir.local_types);
+
+        for (hir::Type_variant& type : ctx.arena.hir.types) {
+            if (auto* structure = std::get_if<hir::type::Structure>(&type)) {
+                apply_shift(shift, structure->name.range);
+            }
+            else if (auto* enumeration = std::get_if<hir::type::Enumeration>(&type)) {
+                apply_shift(shift, enumeration->name.range);
+            }
+        }
+    }
+
+    auto recollect(db::Database& db, Context& ctx, db::Text_edit const& edit) -> bool
+    {
+        auto const& definitions = ctx.definitions;
+
+        // The definitions in [first, last) touch the edited lines.
+        auto const first = static_cast<std::size_t>(
+            std::ranges::partition_point(
+                definitions,
+                [&](Definition const& definition) {
+                    return definition.range.stop.line < edit.start_line;
+                })
+            - definitions.begin());
+        auto const last = static_cast<std::size_t>(
+            std::ranges::partition_point(
+                definitions,
+                [&](Definition const& definition) {
+                    return definition.range.start.line <= edit.old_stop_line;
+                })
+            - definitions.begin());
+
+        // Start right after the previous definition, so that edits between definitions are seen.
+        auto const start = first != 0 ? definitions.at(first - 1).range.stop : lsp::Position {};
+        auto const start_offset = first != 0 ? end_offset(definitions.at(first - 1).view) : 0;
+        auto const old_stop     = last != definitions.size() ? definitions.at(last).range.start
+                                                             : end_of_document;
+
+        erase_region_info(db.documents[ctx.doc_id].info, lsp::Range(start, old_stop));
+
+        if (last != definitions.size()) {
+            auto const lines = static_cast<std::int64_t>(edit.new_stop_line) - edit.old_stop_line;
+            auto const bytes = static_cast<std::int64_t>(edit.new_length) - edit.old_length;
+            shift_document(
+                db, ctx, last, Shift { .from = old_stop, .lines = lines, .bytes = bytes });
+        }
+
+        // Dependents are recollected only if the interface of an edited definition changes.
+        std::vector<Change> changes;
+        if (not recollect_region(db, ctx, first, last, start, start_offset, true, changes)) {
+            return false;
+        }
+
+        // Dependents have not been edited, but they are parsed again so that the information
+        // that was collected for them can be replaced wholesale.
+        for (std::size_t const index : find_dependents(ctx, changes)) {
+            auto const& definition = definitions.at(index);
+            if (not recollect_region(
+                    db,
+                    ctx,
+                    index,
+                    index + 1,
+                    definition.range.start,
+                    definition.view.offset,
+                    false,
+                    changes)) {
+                return false;
+            }
+        }
+
+        for (Change const& change : changes) {
+            reset_definition(ctx, definitions.at(change.index).symbol_id.value());
+        }
+
+        erase_unused_definition_warnings(db, ctx);
+        return true;
+    }
+} // namespace
+
+auto ki::res::recollect_edit(db::Database& db, Context& ctx, db::Text_edit const& edit) -> bool
+{
+    cpputil::always_assert(ctx.active_queries.empty());
+
+    // Recollection is not cancellable, because a partially recollected context can be neither
+    // resumed nor resolved. The parsed region is bounded by the edit and its dependents.
+    auto token = std::exchange(db.cancellation, db::Cancellation_token {});
+    try {
+        bool const result = recollect(db, ctx, edit);
+        db.cancellation   = std::move(token);
+        return result;
+    }
+    catch (...) {
+        db.cancellation = std::move(token);
+        throw;
+    }
+}
+
+auto ki::res::is_retainable(db::Arena const& arena, std::size_t const baseline_size) -> bool
+{
+    return arena.ast.expressions.size() <= 2 * baseline_size;
+}
@@ -24,28 +24,77 @@ auto ki::res::context(db::Document_id doc_id, db::Diagnostic_sink sink) -> Conte
         .doc_id              = doc_id,
         .add_diagnostic      = sink,
         .tags                = {},
+        .definitions         = {},
+        .queries             = {},
+        .active_queries      = {},
     };
 }
 
+auto ki::res::context(Context previous, db::Arena arena, db::Diagnostic_sink sink) -> Context
+{
+    cpputil::always_assert(previous.active_queries.empty());
+    return Context {
+        .arena               = std::move(arena),
+        .builtins            = previous.builtins,
+        .signature_scope_map = std::move(previous.signature_scope_map),
+        .root_env_id         = previous.root_env_id,
+        .doc_id              = previous.doc_id,
+        .add_diagnostic      = sink,
+        .tags                = previous.tags,
+        .definitions         = std::move(previous.definitions),
+        .queries             = std::move(previous.queries),
+        .active_queries      = {},
+    };
+}
+
+ki::res::Query_scope::Query_scope(Context& ctx, Query const query) : m_ctx(ctx)
+{
+    m_ctx.queries.insert_or_assign(query, Query_record {});
+    m_ctx.active_queries.push_back(query);
+}
+
+ki::res::Query_scope::~Query_scope()
+{
+    cpputil::always_assert(not m_ctx.active_queries.empty());
+    auto& dependencies = m_ctx.queries.at(m_ctx.active_queries.back()).dependencies;
+    std::ranges::sort(dependencies);
+    dependencies.erase(std::ranges::unique(dependencies).begin(), dependencies.end());
+    m_ctx.active_queries.pop_back();
+}
+
+void ki::res::record_dependency(Context& ctx, Query const query)
+{
+    if (not ctx.active_queries.empty() and ctx.active_queries.back() != query) {
+        ctx.queries.at(ctx.active_queries.back()).dependencies.push_back(query);
+    }
+}
+
+void ki::res::record_use(Context& ctx, db::Symbol_id const symbol_id)
+{
+    if (not ctx.active_queries.empty()) {
+        ctx.queries.at(ctx.active_queries.back()).uses.push_back(symbol_id);
+    }
+}
+
 auto ki::res::make_builtins(hir::Arena& arena) -> Builtins
 {
     return Builtins {
-        .type_error  = arena.types.push(db::Error {}),
-        .type_never  = arena.types.push(hir::type::Builtin::Never),
-        .type_char   = arena.types.push(hir::type::Builtin::Char),
-        .type_string = arena.types.push(hir::type::Builtin::String),
-        .type_unit   = arena.types.push(hir::type::Tuple {}),
-        .type_bool   = arena.types.push(hir::type::Builtin::Bool),
-        .type_i8     = arena.types.push(hir::type::Builtin::I8),
-        .type_i16    = arena.types.push(hir::type::Builtin::I16),
-        .type_i32    = arena.types.push(hir::type::Builtin::I32),
-        .type_i64    = arena.types.push(hir::type::Builtin::I64),
-        .type_u8     = arena.types.push(hir::type::Builtin::U8),
-        .type_u16    = arena.types.push(hir::type::Builtin::U16),
-        .type_u32    = arena.types.push(hir::type::Builtin::U32),
-        .type_u64    = arena.types.push(hir::type::Builtin::U64),
-        .type_f32    = arena.types.push(hir::type::Builtin::F32),
-        .type_f64    = arena.types.push(hir::type::Builtin::F64),
+        .type_error  = hir::intern_type(arena, db::Error {}),
+        .type_never  = hir::intern_type(arena, hir::type::Builtin::Never),
+        .type_char   = hir::intern_type(arena, hir::type::Builtin::Char),
+        .type_string = hir::intern_type(arena, hir::type::Builtin::String),
+        .type_unit   = hir::intern_type(arena, hir::type::Tuple {}),
+        .type_bool   = hir::intern_type(arena, hir::type::Builtin::Bool),
+        .type_i8     = hir::intern_type(arena, hir::type::Builtin::I8),
+        .type_i16    = hir::intern_type(arena, hir::type::Builtin::I16),
+        .type_i32    = hir::intern_type(arena, hir::type::Builtin::I32),
+        .type_i64    = hir::intern_type(arena, hir::type::Builtin::I64),
+        .type_u8     = hir::intern_type(arena, hir::type::Builtin::U8),
+        .type_u16    = hir::intern_type(arena, hir::type::Builtin::U16),
+        .type_u32    = hir::intern_type(arena, hir::type::Builtin::U32),
+        .type_u64    = hir::intern_type(arena, hir::type::Builtin::U64),
+        .type_f32    = hir::intern_type(arena, hir::type::Builtin::F32),
+        .type_f64    = hir::intern_type(arena, hir::type::Builtin::F64),
         .mut_yes     = arena.mutabilities.push(db::Mutability::Mut),
         .mut_no      = arena.mutabilities.push(db::Mutability::Immut),
         .mut_error   = arena.mutabilities.push(db::Error {}),
@@ -160,27 +209,33 @@ auto ki::res::builtin_expr_type(Context& ctx, hir::expr::Builtin builtin) -> hir
 
 auto ki::res::arith_bin_op_type(Context& ctx, hir::Type_id operand) -> hir::Type_id
 {
-    return ctx.arena.hir.types.push(
+    return hir::intern_type(
+        ctx.arena.hir,
         hir::type::Function {
-            .parameter_types = { operand, operand },
+            .parameter_types = std::pmr::vector<hir::Type_id>(
+                { operand, operand }, ctx.arena.hir.memory.get()),
             .return_type     = operand,
         });
 }
 
 auto ki::res::cmp_bin_op_type(Context& ctx, hir::Type_id operand) -> hir::Type_id
 {
-    return ctx.arena.hir.types.push(
+    return hir::intern_type(
+        ctx.arena.hir,
         hir::type::Function {
-            .parameter_types = { operand, operand },
+            .parameter_types = std::pmr::vector<hir::Type_id>(
+                { operand, operand }, ctx.arena.hir.memory.get()),
             .return_type     = ctx.builtins.type_bool,
         });
 }
 
 auto ki::res::id_op_type(Context& ctx, hir::Type_id operand) -> hir::Type_id
 {
-    return ctx.arena.hir.types.push(
+    return hir::intern_type(
+        ctx.arena.hir,
         hir::type::Function {
-            .parameter_types = { operand },
+            .parameter_types = std::pmr::vector<hir::Type_id>(
+                { operand }, ctx.arena.hir.memory.get()),
             .return_type     = operand,
         });
 }
@@ -295,18 +350,20 @@ void ki::res::flatten_type(Context& ctx, Block_state& state, hir::Type_variant&
         Type_variable_data& data = state.type_vars.at(variable->id.get());
         assert(variable->id == data.var_id);
         if (data.is_solved) {
+            record_type_variable(ctx, state, data.var_id);
             type           = ctx.arena.hir.types[data.type_id];
             data.is_solved = true;
             return;
         }
-        std::size_t index = state.type_var_set.find(data.var_id.get());
-        if (data.var_id.get() == index) {
+        hir::Type_variable_id const repr_id = state.type_var_set.find(data.var_id);
+        if (data.var_id == repr_id) {
             return;
         }
-        Type_variable_data& repr_data = state.type_vars.at(index);
+        Type_variable_data& repr_data = state.type_vars.at(repr_id.get());
         hir::Type_variant&  repr_type = ctx.arena.hir.types[repr_data.type_id];
         flatten_type(ctx, state, repr_type);
         if (repr_data.is_solved) {
+            record_type_variable(ctx, state, data.var_id);
             type           = repr_type;
             data.is_solved = true;
             return;
@@ -321,12 +378,13 @@ void ki::res::set_type_solution(
     hir::Type_variable_id var_id,
     hir::Type_variant     solution)
 {
-    auto& repr_data = state.type_vars.at(state.type_var_set.find(var_id.get()));
+    auto& repr_data = state.type_vars.at(state.type_var_set.find(var_id).get());
     auto& repr_type = ctx.arena.hir.types[repr_data.type_id];
     if (repr_data.is_solved) {
         require_subtype_relationship(
             db, ctx, state, state.type_vars.at(var_id.get()).origin, solution, repr_type);
     }
+    record_type_variable(ctx, state, repr_data.var_id);
     repr_type           = std::move(solution);
     repr_data.is_solved = true;
 }
@@ -338,7 +396,7 @@ void ki::res::set_mut_solution(
     hir::Mutability_variable_id var_id,
     hir::Mutability_variant     solution)
 {
-    auto& repr = state.mut_vars.at(state.mut_var_set.find(var_id.get()));
+    auto& repr = state.mut_vars.at(state.mut_var_set.find(var_id).get());
 
     if (repr.is_solved) {
         require_submutability_relationship(
@@ -350,6 +408,7 @@ void ki::res::set_mut_solution(
             ctx.arena.hir.mutabilities[repr.mut_id]);
     }
 
+    record_mut_variable(ctx, state, repr.var_id);
     ctx.arena.hir.mutabilities[repr.mut_id] = std::move(solution);
     repr.is_solved                          = true;
 }
@@ -423,8 +482,98 @@ void ki::res::ensure_no_unsolved_variables(db::Database& db, Context& ctx, Block
     }
 }
 
+namespace {
+    void close_snapshot(ki::res::Block_state& state)
+    {
+        cpputil::always_assert(state.open_snapshots != 0);
+
+        // The outermost snapshot has no use for the log once it is closed.
+        if (--state.open_snapshots == 0) {
+            state.undo_log.clear();
+        }
+    }
+} // namespace
+
+void ki::res::record_type_variable(Context& ctx, Block_state& state, hir::Type_variable_id var_id)
+{
+    if (state.open_snapshots != 0) {
+        Type_variable_data const& data = state.type_vars.at(var_id.get());
+        state.undo_log.emplace_back(
+            Type_variable_undo { .data = data, .type = ctx.arena.hir.types[data.type_id] });
+    }
+}
+
+void ki::res::record_mut_variable(
+    Context& ctx, Block_state& state, hir::Mutability_variable_id var_id)
+{
+    if (state.open_snapshots != 0) {
+        Mutability_variable_data const& data = state.mut_vars.at(var_id.get());
+        state.undo_log.emplace_back(
+            Mutability_variable_undo {
+                .data       = data,
+                .mutability = ctx.arena.hir.mutabilities[data.mut_id],
+            });
+    }
+}
+
+auto ki::res::snapshot(Block_state& state) -> Block_snapshot
+{
+    ++state.open_snapshots;
+    return Block_snapshot {
+        .type_var_set   = state.type_var_set.snapshot(),
+        .mut_var_set    = state.mut_var_set.snapshot(),
+        .type_var_count = state.type_vars.size(),
+        .mut_var_count  = state.mut_vars.size(),
+        .undo_log_size  = state.undo_log.size(),
+        .loop_info      = state.loop_info,
+    };
+}
+
+void ki::res::rollback(Context& ctx, Block_state& state, Block_snapshot snapshot)
+{
+    cpputil::always_assert(snapshot.undo_log_size <= state.undo_log.size());
+
+    auto const visitor = utl::Overload {
+        [&](Type_variable_undo& undo) {
+            ctx.arena.hir.types[undo.data.type_id]     = std::move(undo.type);
+            state.type_vars.at(undo.data.var_id.get()) = undo.data;
+        },
+        [&](Mutability_variable_undo& undo) {
+            ctx.arena.hir.mutabilities[undo.data.mut_id] = std::move(undo.mutability);
+            state.mut_vars.at(undo.data.var_id.get())    = undo.data;
+        },
+    };
+
+    while (state.undo_log.size() != snapshot.undo_log_size) {
+        std::visit(visitor, state.undo_log.back());
+        state.undo_log.pop_back();
+    }
+
+    auto const truncate = [](auto& vector, std::size_t const size) {
+        vector.erase(vector.begin() + cpputil::num::safe_cast<std::ptrdiff_t>(size), vector.end());
+    };
+    truncate(state.type_vars, snapshot.type_var_count);
+    truncate(state.mut_vars, snapshot.mut_var_count);
+    state.loop_info = std::move(snapshot.loop_info);
+
+    state.type_var_set.rollback(snapshot.type_var_set);
+    state.mut_var_set.rollback(snapshot.mut_var_set);
+    close_snapshot(state);
+}
+
+void ki::res::commit(Block_state& state, Block_snapshot snapshot)
+{
+    cpputil::always_assert(snapshot.undo_log_size <= state.undo_log.size());
+
+    state.type_var_set.commit(snapshot.type_var_set);
+    state.mut_var_set.commit(snapshot.mut_var_set);
+    close_snapshot(state);
+}
+
 void ki::res::resolve_symbol(db::Database& db, Context& ctx, db::Symbol_id symbol_id)
 {
+    db::check_cancellation(db.cancellation);
+
     auto const visitor = utl::Overload {
         [&](hir::Function_id id) { resolve_function_body(db, ctx, id); },
         [&](hir::Structure_id id) { resolve_structure(db, ctx, id); },
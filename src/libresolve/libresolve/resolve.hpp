@@ -50,12 +50,38 @@ namespace ki::res {
         ast::Loop_source            source {};
     };
 
+    // The state of a type variable and its arena slot before a change.
+    struct Type_variable_undo {
+        Type_variable_data data;
+        hir::Type_variant  type;
+    };
+
+    // The state of a mutability variable and its arena slot before a change.
+    struct Mutability_variable_undo {
+        Mutability_variable_data data;
+        hir::Mutability_variant  mutability;
+    };
+
+    using Block_undo = std::variant<Type_variable_undo, Mutability_variable_undo>;
+
     struct Block_state {
-        std::vector<Type_variable_data>       type_vars;
-        utl::Disjoint_set                     type_var_set;
-        std::vector<Mutability_variable_data> mut_vars;
-        utl::Disjoint_set                     mut_var_set;
-        std::optional<Loop_info>              loop_info;
+        std::vector<Type_variable_data>                type_vars;
+        utl::Disjoint_set<hir::Type_variable_id>       type_var_set;
+        std::vector<Mutability_variable_data>          mut_vars;
+        utl::Disjoint_set<hir::Mutability_variable_id> mut_var_set;
+        std::optional<Loop_info>                       loop_info;
+        std::vector<Block_undo>                        undo_log;
+        std::size_t                                    open_snapshots {};
+    };
+
+    // The state of a block at some point in time. Snapshots must be closed in LIFO order.
+    struct Block_snapshot {
+        utl::Disjoint_set<hir::Type_variable_id>::Snapshot       type_var_set;
+        utl::Disjoint_set<hir::Mutability_variable_id>::Snapshot mut_var_set;
+        std::size_t                                              type_var_count {};
+        std::size_t                                              mut_var_count {};
+        std::size_t                                              undo_log_size {};
+        std::optional<Loop_info>                                 loop_info;
     };
 
     struct Tags {
@@ -66,20 +92,81 @@ namespace ki::res {
     using Signature_scope_map
         = std::unordered_map<hir::Function_id, db::Environment_id, utl::Hash_vector_index>;
 
+    enum struct Query_kind : std::uint8_t {
+        Function_signature,
+        Function_body,
+        Structure,
+        Enumeration,
+        Concept,
+        Alias,
+    };
+
+    // Identifies a memoized definition query. Query results are cached in the HIR arena.
+    struct Query {
+        Query_kind  kind {};
+        std::size_t id {};
+
+        auto operator==(Query const&) const -> bool                  = default;
+        auto operator<=>(Query const&) const -> std::strong_ordering = default;
+    };
+
+    // Dependencies recorded while computing a query.
+    struct Query_record {
+        std::vector<Query>         dependencies; // Queries demanded by the query.
+        std::vector<db::Symbol_id> uses;         // Symbols whose use counts were incremented.
+    };
+
+    using Query_map = std::map<Query, Query_record>;
+
+    // A top-level definition or block delimiter, in source order. The interface of a definition
+    // is the prefix of its text that other definitions can depend on: the signature of a
+    // function, or the whole text of any other definition.
+    struct Definition {
+        lsp::Range                   range;
+        utl::View                    view;
+        std::optional<db::Symbol_id> symbol_id;
+        std::size_t                  block_depth {}; // Block nesting depth after the definition.
+        std::size_t                  interface_hash {};
+        std::uint32_t                interface_length {};
+    };
+
     // Resolution context for a single document.
     struct Context {
-        db::Arena           arena;
-        Builtins            builtins;
-        Signature_scope_map signature_scope_map;
-        db::Environment_id  root_env_id;
-        db::Document_id     doc_id;
-        db::Diagnostic_sink add_diagnostic;
-        Tags                tags;
+        db::Arena               arena;
+        Builtins                builtins;
+        Signature_scope_map     signature_scope_map;
+        db::Environment_id      root_env_id;
+        db::Document_id         doc_id;
+        db::Diagnostic_sink     add_diagnostic;
+        Tags                    tags;
+        std::vector<Definition> definitions;
+        Query_map               queries;
+        std::vector<Query>      active_queries;
+    };
+
+    // Makes a query active for the duration of its lifetime.
+    class Query_scope {
+        Context& m_ctx;
+    public:
+        Query_scope(Context& ctx, Query query);
+        Query_scope(Query_scope const&) = delete;
+        auto operator=(Query_scope const&) -> Query_scope& = delete;
+        ~Query_scope();
     };
 
     // Create a resolution context for the given document.
     auto context(db::Document_id doc_id, db::Diagnostic_sink sink) -> Context;
 
+    // Create a resolution context that continues the analysis described by `previous`.
+    // `arena` must be the arena that was produced by that analysis.
+    auto context(Context previous, db::Arena arena, db::Diagnostic_sink sink) -> Context;
+
+    // Record that the active query, if any, depends on `query`.
+    void record_dependency(Context& ctx, Query query);
+
+    // Record that the active query, if any, incremented the use count of `symbol_id`.
+    void record_use(Context& ctx, db::Symbol_id symbol_id);
+
     // Construct `Builtins`.
     auto make_builtins(hir::Arena& arena) -> Builtins;
 
@@ -131,10 +218,51 @@ namespace ki::res {
 
     void ensure_no_unsolved_variables(db::Database& db, Context& ctx, Block_state& state);
 
+    // Record the current state of a type variable, if there are open snapshots.
+    void record_type_variable(Context& ctx, Block_state& state, hir::Type_variable_id var_id);
+
+    // Record the current state of a mutability variable, if there are open snapshots.
+    void record_mut_variable(Context& ctx, Block_state& state, hir::Mutability_variable_id var_id);
+
+    // Start recording changes to `state`, so that they can be undone with `rollback`.
+    auto snapshot(Block_state& state) -> Block_snapshot;
+
+    // Undo every change made to `state` since `snapshot` was taken. Nodes that were pushed to the
+    // arena in the meantime are left in place, but are no longer referred to by `state`.
+    void rollback(Context& ctx, Block_state& state, Block_snapshot snapshot);
+
+    // Keep the changes made to `state` since `snapshot` was taken.
+    void commit(Block_state& state, Block_snapshot snapshot);
+
     // Collect definitions from the active document.
     // Returns a vector of symbols in the order they should be resolved.
     auto collect_document(db::Database& db, Context& ctx) -> std::vector<db::Symbol_id>;
 
+    // Compute the length of the signature of `function`, which spans `view` in `text`.
+    auto signature_length(
+        cst::Arena const&    arena,
+        std::string_view     text,
+        utl::View            view,
+        cst::Function const& function) -> std::uint32_t;
+
+    // Hash the interface of `definition`, which spans its view in `text`. Interfaces are compared
+    // by hash after an edit, so the previous text of a document does not have to be kept.
+    auto interface_hash(std::string_view text, Definition const& definition) -> std::size_t;
+
+    // Bring a collected document up to date after `edit` was applied to its text. Only the
+    // definitions that overlap the edit are parsed again, and the information collected for the
+    // definitions after it is shifted into place. Every query that depends on an edited interface
+    // is invalidated, so that resolving the document's symbols again recomputes only what the
+    // edit affected. Returns false if the edit can not be handled incrementally, in which case
+    // the document must be collected from scratch with a fresh context. Recollection ignores
+    // the cancellation token of `db`, so `ctx` is never left partially recollected.
+    auto recollect_edit(db::Database& db, Context& ctx, db::Text_edit const& edit) -> bool;
+
+    // Each recollection leaves the replaced AST nodes behind in the arena, so a document is
+    // analyzed from scratch once its arena has grown too much since the last full analysis,
+    // after which the arena held `baseline_size` expressions.
+    auto is_retainable(db::Arena const& arena, std::size_t baseline_size) -> bool;
+
     auto resolve_structure(db::Database& db, Context& ctx, hir::Structure_id id) -> hir::Structure&;
 
     auto resolve_enumeration(db::Database& db, Context& ctx, hir::Enumeration_id id)
@@ -215,6 +343,15 @@ namespace ki::res {
         hir::Type_variant const& sub,
         hir::Type_variant const& super);
 
+    // Check whether `sub` is equal to or a subtype of `super`, unifying them if so. On failure,
+    // every change to `state` is rolled back and no diagnostic is emitted.
+    auto try_subtype_relationship(
+        db::Database&            db,
+        Context&                 ctx,
+        Block_state&             state,
+        hir::Type_variant const& sub,
+        hir::Type_variant const& super) -> bool;
+
     // Require that `sub` is equal to or a submutability of `super`.
     void require_submutability_relationship(
         db::Database&                  db,
@@ -63,13 +63,15 @@ namespace {
 
         auto parameters = std::ranges::to<std::vector>(
             std::views::transform(signature.function_parameters, resolve_parameter));
-        auto parameter_types = std::ranges::to<std::vector>(
-            std::views::transform(parameters, &hir::Function_parameter::type_id));
+        auto parameter_types = std::ranges::to<std::pmr::vector<hir::Type_id>>(
+            std::views::transform(parameters, &hir::Function_parameter::type_id),
+            ctx.arena.hir.memory.get());
 
         auto const return_type = resolve_type(
             db, ctx, state, signature_env_id, ctx.arena.ast.types[signature.return_type]);
 
-        auto const function_type_id = ctx.arena.hir.types.push(
+        auto const function_type_id = hir::intern_type(
+            ctx.arena.hir,
             hir::type::Function {
                 .parameter_types = std::move(parameter_types),
                 .return_type     = return_type,
@@ -111,13 +113,14 @@ namespace {
                     = std::ranges::to<std::vector>(std::views::transform(tuple.types, resolve));
 
                 hir::type::Function function_type {
-                    .parameter_types = field_types,
+                    .parameter_types = std::pmr::vector<hir::Type_id>(
+                        field_types.begin(), field_types.end(), ctx.arena.hir.memory.get()),
                     .return_type     = owner_type_id,
                 };
 
                 return hir::Tuple_constructor {
                     .types            = std::move(field_types),
-                    .function_type_id = ctx.arena.hir.types.push(std::move(function_type)),
+                    .function_type_id = hir::intern_type(ctx.arena.hir, std::move(function_type)),
                 };
             },
             [&](ast::Struct_constructor const& structure) -> hir::Constructor_body {
@@ -170,16 +173,20 @@ auto ki::res::resolve_function_body(db::Database& db, Context& ctx, hir::Functio
 {
     hir::Function_info& info = ctx.arena.hir.functions[id];
 
+    auto const query = Query { .kind = Query_kind::Function_body, .id = id.get() };
+    record_dependency(ctx, query);
+
     if (not info.body_id.has_value()) {
+        auto  scope     = Query_scope(ctx, query);
         auto  state     = Block_state {};
         auto& signature = resolve_function_signature(db, ctx, id);
 
+        // The signature scope is kept, the body is resolved again if it is invalidated.
         auto const it = ctx.signature_scope_map.find(id);
         cpputil::always_assert(it != ctx.signature_scope_map.end());
         hir::Expression body = resolve_expression(
             db, ctx, state, it->second, ctx.arena.ast.expressions[info.ast.body]);
         report_unused(db, ctx, it->second);
-        ctx.signature_scope_map.erase(it);
 
         require_subtype_relationship(
             db,
@@ -199,7 +206,12 @@ auto ki::res::resolve_function_signature(db::Database& db, Context& ctx, hir::Fu
     -> hir::Function_signature&
 {
     hir::Function_info& info = ctx.arena.hir.functions[id];
+
+    auto const query = Query { .kind = Query_kind::Function_signature, .id = id.get() };
+    record_dependency(ctx, query);
+
     if (not info.signature.has_value()) {
+        auto scope = Query_scope(ctx, query);
         resolve_signature(db, ctx, id, info.env_id, info.ast.signature);
     }
     return info.signature.value();
@@ -209,7 +221,13 @@ auto ki::res::resolve_structure(db::Database& db, Context& ctx, hir::Structure_i
     -> hir::Structure&
 {
     hir::Structure_info& info = ctx.arena.hir.structures[id];
+
+    auto const query = Query { .kind = Query_kind::Structure, .id = id.get() };
+    record_dependency(ctx, query);
+
     if (not info.hir.has_value()) {
+        auto scope = Query_scope(ctx, query);
+
         auto const ctor_env_id = ctx.arena.environments.push(
             db::Environment {
                 .map       = {},
@@ -246,7 +264,13 @@ auto ki::res::resolve_enumeration(db::Database& db, Context& ctx, hir::Enumerati
     -> hir::Enumeration&
 {
     hir::Enumeration_info& info = ctx.arena.hir.enumerations[id];
+
+    auto const query = Query { .kind = Query_kind::Enumeration, .id = id.get() };
+    record_dependency(ctx, query);
+
     if (not info.hir.has_value()) {
+        auto scope = Query_scope(ctx, query);
+
         auto const ctor_env_id = ctx.arena.environments.push(
             db::Environment {
                 .map       = {},
@@ -297,7 +321,13 @@ auto ki::res::resolve_concept(db::Database& db, Context& ctx, hir::Concept_id id
     (void)db;
 
     hir::Concept_info& info = ctx.arena.hir.concepts[id];
+
+    auto const query = Query { .kind = Query_kind::Concept, .id = id.get() };
+    record_dependency(ctx, query);
+
     if (not info.hir.has_value()) {
+        auto scope = Query_scope(ctx, query);
+
         std::string message = "Concept resolution has not been implemented yet";
         ctx.add_diagnostic(lsp::error(info.name.range, std::move(message)));
         info.hir = hir::Concept {};
@@ -308,7 +338,12 @@ auto ki::res::resolve_concept(db::Database& db, Context& ctx, hir::Concept_id id
 auto ki::res::resolve_alias(db::Database& db, Context& ctx, hir::Alias_id id) -> hir::Alias&
 {
     hir::Alias_info& info = ctx.arena.hir.aliases[id];
+
+    auto const query = Query { .kind = Query_kind::Alias, .id = id.get() };
+    record_dependency(ctx, query);
+
     if (not info.hir.has_value()) {
+        auto scope = Query_scope(ctx, query);
         auto state = Block_state {};
         auto type  = resolve_type(db, ctx, state, info.env_id, ctx.arena.ast.types[info.ast.type]);
         ensure_no_unsolved_variables(db, ctx, state);
@@ -166,7 +166,7 @@ namespace {
         {
             auto const element_type_id = fresh_general_type_variable(ctx, state, this_range);
 
-            std::vector<hir::Expression_id> elements;
+            std::pmr::vector<hir::Expression_id> elements(ctx.arena.hir.memory.get());
             elements.reserve(array.elements.size());
 
             for (ast::Expression_id element_id : array.elements) {
@@ -190,7 +190,8 @@ namespace {
                     .range    = this_range,
                 });
 
-            auto const type_id = ctx.arena.hir.types.push(
+            auto const type_id = hir::intern_type(
+                ctx.arena.hir,
                 hir::type::Array {
                     .element_type = element_type_id,
                     .length       = length,
@@ -211,8 +212,8 @@ namespace {
                 return unit_expression(ctx, this_range);
             }
 
-            std::vector<hir::Type_id>       types;
-            std::vector<hir::Expression_id> fields;
+            std::pmr::vector<hir::Type_id>       types(ctx.arena.hir.memory.get());
+            std::pmr::vector<hir::Expression_id> fields(ctx.arena.hir.memory.get());
 
             types.reserve(tuple.fields.size());
             fields.reserve(tuple.fields.size());
@@ -225,7 +226,7 @@ namespace {
 
             return hir::Expression {
                 .variant  = hir::expr::Tuple { std::move(fields) },
-                .type_id  = ctx.arena.hir.types.push(hir::type::Tuple { std::move(types) }),
+                .type_id  = hir::intern_type(ctx.arena.hir, hir::type::Tuple { std::move(types) }),
                 .mut_id   = ctx.builtins.mut_no,
                 .category = hir::Expression_category::Value,
                 .range    = this_range,
@@ -315,8 +316,8 @@ namespace {
                 return ctx.arena.hir.expressions.push(std::move(effect));
             };
 
-            auto side_effects = std::ranges::to<std::vector>(
-                std::views::transform(block.effects, resolve_effect));
+            auto side_effects = std::ranges::to<std::pmr::vector<hir::Expression_id>>(
+                std::views::transform(block.effects, resolve_effect), ctx.arena.hir.memory.get());
 
             auto result = resolve_expression(
                 db, ctx, state, block_env_id, ctx.arena.ast.expressions[block.result]);
@@ -354,7 +355,7 @@ namespace {
                     return error(this_range, std::move(message));
                 }
 
-                std::vector<hir::Expression_id> arguments;
+                std::pmr::vector<hir::Expression_id> arguments(ctx.arena.hir.memory.get());
                 arguments.reserve(signature.parameters.size());
 
                 for (std::size_t index = 0; index != call.arguments.size(); ++index) {
@@ -387,10 +388,12 @@ namespace {
                 };
             }
 
-            std::vector<hir::Expression_id> arguments;
+            std::pmr::vector<hir::Expression_id> arguments(ctx.arena.hir.memory.get());
             arguments.reserve(call.arguments.size());
 
-            std::vector<hir::Type_id> parameter_types;
+            // The synthetic function type below is never pushed, so its parameter types need not
+            // be allocated from the arena.
+            std::pmr::vector<hir::Type_id> parameter_types;
             parameter_types.reserve(call.arguments.size());
 
             auto result_type_id = fresh_general_type_variable(ctx, state, this_range);
@@ -511,8 +514,8 @@ namespace {
                                    | std::ranges::to<std::vector>();
 
             if (missing_field_ids.empty()) {
-                auto arguments = std::ranges::to<std::vector>(
-                    std::views::repeat(hir::Expression_id(0), body->fields.size()));
+                std::pmr::vector<hir::Expression_id> arguments(
+                    body->fields.size(), hir::Expression_id(0), ctx.arena.hir.memory.get());
 
                 for (auto& [field_index, argument] : map) {
                     arguments.at(field_index) = ctx.arena.hir.expressions.push(std::move(argument));
@@ -666,15 +669,21 @@ namespace {
                 ctx.arena.hir.types[condition.type_id],
                 hir::type::Builtin::Bool);
 
-            require_subtype_relationship(
-                db,
-                ctx,
-                state,
-                false_branch.range,
-                ctx.arena.hir.types[false_branch.type_id],
-                ctx.arena.hir.types[true_branch.type_id]);
+            auto const& true_type   = ctx.arena.hir.types[true_branch.type_id];
+            auto const& false_type  = ctx.arena.hir.types[false_branch.type_id];
+            auto        result_type = true_branch.type_id;
 
-            auto result_type = true_branch.type_id;
+            // Prefer the type of the true branch, but fall back to the false branch when only
+            // that direction unifies, for example when the true branch diverges.
+            if (not try_subtype_relationship(db, ctx, state, false_type, true_type)) {
+                if (try_subtype_relationship(db, ctx, state, true_type, false_type)) {
+                    result_type = false_branch.type_id;
+                }
+                else {
+                    require_subtype_relationship(
+                        db, ctx, state, false_branch.range, false_type, true_type);
+                }
+            }
 
             auto arm = [&](bool boolean, hir::Expression branch) {
                 return hir::Match_arm {
@@ -853,7 +862,7 @@ namespace {
                         .mutability = { .id = mut_id, .range = mutability.range },
                         .expression = ctx.arena.hir.expressions.push(std::move(place)),
                     },
-                    .type_id  = ctx.arena.hir.types.push(hir::type::Reference {
+                    .type_id  = hir::intern_type(ctx.arena.hir, hir::type::Reference {
                         .referenced_type = place_type,
                         .mutability = { .id = mut_id, .range = mutability.range },
                     }),
@@ -17,7 +17,7 @@ namespace {
     auto make_path(db::Name name) -> ast::Path
     {
         ast::Path_segment segment { .template_arguments = std::nullopt, .name = name };
-        return ast::Path { .root = {}, .segments = utl::to_vector({ std::move(segment) }) };
+        return ast::Path { .root = {}, .segments = { std::move(segment) } };
     }
 } // namespace
 
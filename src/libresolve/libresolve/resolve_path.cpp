@@ -68,6 +68,7 @@ namespace {
                 ctx.add_diagnostic(lsp::error(segment.name.range, std::move(message)));
             }
             ++ctx.arena.symbols[it->second].use_count;
+            record_use(ctx, it->second);
             db::add_reference(db, ctx.doc_id, lsp::read(segment.name.range), it->second);
             return it->second;
         }
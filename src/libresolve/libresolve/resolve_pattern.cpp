@@ -100,8 +100,8 @@ namespace {
 
         auto operator()(ast::patt::Tuple const& tuple) -> hir::Pattern
         {
-            std::vector<hir::Pattern> fields;
-            std::vector<hir::Type_id> types;
+            std::vector<hir::Pattern>      fields;
+            std::pmr::vector<hir::Type_id> types(ctx.arena.hir.memory.get());
 
             fields.reserve(tuple.fields.size());
             types.reserve(tuple.fields.size());
@@ -114,7 +114,7 @@ namespace {
 
             return hir::Pattern {
                 .variant = hir::patt::Tuple { std::move(fields) },
-                .type_id = ctx.arena.hir.types.push(hir::type::Tuple { std::move(types) }),
+                .type_id = hir::intern_type(ctx.arena.hir, hir::type::Tuple { std::move(types) }),
                 .range   = this_range,
             };
         }
@@ -140,7 +140,7 @@ namespace {
 
             return hir::Pattern {
                 .variant = hir::patt::Slice { std::move(elements) },
-                .type_id = ctx.arena.hir.types.push(hir::type::Slice { element_type_id }),
+                .type_id = hir::intern_type(ctx.arena.hir, hir::type::Slice { element_type_id }),
                 .range   = this_range,
             };
         }
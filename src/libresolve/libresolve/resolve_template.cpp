@@ -37,7 +37,8 @@ namespace {
             auto const local_id = ctx.arena.hir.local_types.push(
                 hir::Local_type {
                     .name    = parameter.name,
-                    .type_id = ctx.arena.hir.types.push(
+                    .type_id = hir::intern_type(
+                        ctx.arena.hir,
                         hir::type::Parameterized {
                             .tag = tag,
                             .id  = parameter.name.id,
@@ -62,11 +62,13 @@ namespace {
 
         auto operator()(ast::type::Tuple const& tuple) -> hir::Type_id
         {
-            return ctx.arena.hir.types.push(
+            return hir::intern_type(
+                ctx.arena.hir,
                 hir::type::Tuple {
                     .types = tuple.fields
                            | std::views::transform(std::bind_front(&Visitor::recurse, this))
-                           | std::ranges::to<std::vector>(),
+                           | std::ranges::to<std::pmr::vector<hir::Type_id>>(
+                                 ctx.arena.hir.memory.get()),
                 });
         }
 
@@ -74,7 +76,8 @@ namespace {
         {
             auto length = resolve_expression(
                 db, ctx, state, env_id, ctx.arena.ast.expressions[array.length]);
-            return ctx.arena.hir.types.push(
+            return hir::intern_type(
+                ctx.arena.hir,
                 hir::type::Array {
                     .element_type = recurse(array.element_type),
                     .length       = ctx.arena.hir.expressions.push(std::move(length)),
@@ -83,18 +86,20 @@ namespace {
 
         auto operator()(ast::type::Slice const& slice) -> hir::Type_id
         {
-            return ctx.arena.hir.types.push(
+            return hir::intern_type(
+                ctx.arena.hir,
                 hir::type::Slice { .element_type = recurse(slice.element_type) });
         }
 
         auto operator()(ast::type::Function const& function) -> hir::Type_id
         {
-            return ctx.arena.hir.types.push(
+            return hir::intern_type(
+                ctx.arena.hir,
                 hir::type::Function {
                     .parameter_types
                     = function.parameter_types
                     | std::views::transform(std::bind_front(&Visitor::recurse, this))
-                    | std::ranges::to<std::vector>(),
+                    | std::ranges::to<std::pmr::vector<hir::Type_id>>(ctx.arena.hir.memory.get()),
                     .return_type = recurse(function.return_type),
                 });
         }
@@ -111,7 +116,8 @@ namespace {
 
         auto operator()(ast::type::Reference const& reference) -> hir::Type_id
         {
-            return ctx.arena.hir.types.push(
+            return hir::intern_type(
+                ctx.arena.hir,
                 hir::type::Reference {
                     .referenced_type = recurse(reference.referenced_type),
                     .mutability      = resolve_mutability(db, ctx, env_id, reference.mutability),
@@ -120,7 +126,8 @@ namespace {
 
         auto operator()(ast::type::Pointer const& pointer) -> hir::Type_id
         {
-            return ctx.arena.hir.types.push(
+            return hir::intern_type(
+                ctx.arena.hir,
                 hir::type::Pointer {
                     .pointee_type = recurse(pointer.pointee_type),
                     .mutability   = resolve_mutability(db, ctx, env_id, pointer.mutability),
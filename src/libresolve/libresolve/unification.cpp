@@ -76,7 +76,7 @@ namespace {
         auto operator()(hir::mut::Variable sub, hir::mut::Variable super) const -> Result
         {
             if (sub.id != super.id) {
-                state.mut_var_set.merge(sub.id.get(), super.id.get());
+                state.mut_var_set.merge(sub.id, super.id);
             }
             return Result::Ok;
         }
@@ -135,6 +135,10 @@ namespace {
 
         auto unify(hir::Type_id sub, hir::Type_id super) const -> Result
         {
+            // Structurally identical types are interned, so this catches most trivial cases.
+            if (sub == super) {
+                return Result::Ok;
+            }
             return unify(ctx.arena.hir.types[sub], ctx.arena.hir.types[super]);
         }
 
@@ -168,9 +172,11 @@ namespace {
         auto operator()(hir::type::Variable sub, hir::type::Variable super) const -> Result
         {
             if (sub.id != super.id) {
+                record_type_variable(ctx, state, sub.id);
+                record_type_variable(ctx, state, super.id);
                 merge_variable_kinds(
                     state.type_vars.at(sub.id.get()).kind, state.type_vars.at(super.id.get()).kind);
-                state.type_var_set.merge(sub.id.get(), super.id.get());
+                state.type_var_set.merge(sub.id, super.id);
             }
             return Result::Ok;
         }
@@ -353,3 +359,38 @@ void ki::res::require_submutability_relationship(
         ctx.add_diagnostic(lsp::error(range, std::format("Could not unify {} ~> {}", left, right)));
     }
 }
+
+auto ki::res::try_subtype_relationship(
+    db::Database&            db,
+    Context&                 ctx,
+    Block_state&             state,
+    hir::Type_variant const& sub,
+    hir::Type_variant const& super) -> bool
+{
+    // Conflicting solutions found while unifying are reported by nested relationship checks.
+    bool has_conflict  = false;
+    auto conflict_sink = [&](lsp::Diagnostic) { has_conflict = true; };
+
+    auto const add_diagnostic
+        = std::exchange(ctx.add_diagnostic, db::Diagnostic_sink(conflict_sink));
+
+    Type_visitor visitor {
+        .db            = db,
+        .ctx           = ctx,
+        .state         = state,
+        .current_sub   = sub,
+        .current_super = super,
+        .goal          = Goal::Subtype,
+    };
+    auto block_snapshot = snapshot(state);
+    bool const is_ok    = visitor.unify(sub, super) == Result::Ok and not has_conflict;
+    ctx.add_diagnostic  = add_diagnostic;
+
+    if (is_ok) {
+        commit(state, std::move(block_snapshot));
+    }
+    else {
+        rollback(ctx, state, std::move(block_snapshot));
+    }
+    return is_ok;
+}
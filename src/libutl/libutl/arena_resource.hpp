@@ -0,0 +1,44 @@
+#ifndef KIELI_LIBUTL_ARENA_RESOURCE
+#define KIELI_LIBUTL_ARENA_RESOURCE
+
+#include <libutl/utilities.hpp>
+
+namespace ki::utl {
+
+    // Owns a monotonic memory resource. Allocations are pointer bumps, and the memory is released
+    // all at once when the owner is destroyed.
+    class Arena_resource {
+        std::unique_ptr<std::pmr::monotonic_buffer_resource> m_resource;
+    public:
+        static constexpr std::size_t initial_size = 16 * 1024;
+
+        Arena_resource()
+            : m_resource(std::make_unique<std::pmr::monotonic_buffer_resource>(initial_size))
+        {}
+
+        Arena_resource(Arena_resource const&) = delete;
+
+        Arena_resource(Arena_resource&& other) noexcept = default;
+
+        auto operator=(Arena_resource const&) -> Arena_resource& = delete;
+
+        // Swap rather than release, so that the resource previously owned by `this` outlives any
+        // containers that are destroyed when the rest of the enclosing arena is move-assigned.
+        auto operator=(Arena_resource&& other) noexcept -> Arena_resource&
+        {
+            std::swap(m_resource, other.m_resource);
+            return *this;
+        }
+
+        ~Arena_resource() = default;
+
+        // The resource to allocate from. A moved-from arena falls back to the default resource.
+        [[nodiscard]] auto get() const noexcept -> std::pmr::memory_resource*
+        {
+            return m_resource ? m_resource.get() : std::pmr::get_default_resource();
+        }
+    };
+
+} // namespace ki::utl
+
+#endif // KIELI_LIBUTL_ARENA_RESOURCE
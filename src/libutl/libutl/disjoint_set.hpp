@@ -2,27 +2,158 @@
 #define KIELI_LIBUTL_DISJOINT_SET
 
 #include <libutl/utilities.hpp>
+#include <libutl/index_vector.hpp>
 
 namespace ki::utl {
 
+    // Union-find over `Index`. Each node is a single 32-bit entry: non-root entries hold the index
+    // of the parent, and root entries hold the rank of the tree, tagged with `root_bit`.
+    template <vector_index Index>
     class Disjoint_set {
-        std::vector<std::size_t> m_parents;
-        std::vector<std::size_t> m_weights;
+        static constexpr std::uint32_t root_bit = std::uint32_t { 1 } << 31;
+
+        struct Undo {
+            std::uint32_t index {};
+            std::uint32_t entry {};
+        };
+
+        std::vector<std::uint32_t> m_entries;
+        std::vector<Undo>          m_undo_log;
+        std::size_t                m_open_snapshots {};
+
+        [[nodiscard]] static auto is_root(std::uint32_t const entry) noexcept -> bool
+        {
+            return (entry & root_bit) != 0;
+        }
+
+        [[nodiscard]] static auto to_entry(Index const index) -> std::uint32_t
+        {
+            auto const entry = cpputil::num::safe_cast<std::uint32_t>(index.get());
+            cpputil::always_assert(not is_root(entry));
+            return entry;
+        }
+
+        // Record the entry of `x` if there are open snapshots.
+        void record(std::uint32_t const x)
+        {
+            if (m_open_snapshots != 0) {
+                m_undo_log.push_back(Undo { .index = x, .entry = m_entries.at(x) });
+            }
+        }
+
+        [[nodiscard]] auto find_root(std::uint32_t x) -> std::uint32_t
+        {
+            // Path halving: point every other node on the path to its grandparent.
+            for (;;) {
+                std::uint32_t const parent = m_entries.at(x);
+                if (is_root(parent)) {
+                    return x;
+                }
+                std::uint32_t const grandparent = m_entries.at(parent);
+                if (is_root(grandparent)) {
+                    return parent;
+                }
+                record(x);
+                m_entries.at(x) = grandparent;
+                x               = grandparent;
+            }
+        }
+
+        void close_snapshot()
+        {
+            cpputil::always_assert(m_open_snapshots != 0);
+
+            // The outermost snapshot has no use for the log once it is closed.
+            if (--m_open_snapshots == 0) {
+                m_undo_log.clear();
+            }
+        }
     public:
+        // The state of the set at some point in time. Snapshots must be closed in LIFO order.
+        struct Snapshot {
+            std::size_t size {};
+            std::size_t undo_log_size {};
+        };
+
         Disjoint_set() = default;
-        explicit Disjoint_set(std::size_t size);
+
+        explicit Disjoint_set(std::size_t const size) : m_entries(size, root_bit) {}
 
         // Replace the set containing `x` and the set containing `y` with their union.
-        void merge(std::size_t x, std::size_t y);
+        void merge(Index const x, Index const y)
+        {
+            std::uint32_t x_root = find_root(to_entry(x));
+            std::uint32_t y_root = find_root(to_entry(y));
+            if (x_root == y_root) {
+                return;
+            }
+            if (m_entries.at(x_root) < m_entries.at(y_root)) {
+                std::swap(x_root, y_root);
+            }
+            record(y_root);
+            if (m_entries.at(x_root) == m_entries.at(y_root)) {
+                record(x_root);
+                ++m_entries.at(x_root);
+            }
+            m_entries.at(y_root) = x_root;
+        }
 
         // Add a new node to the set.
-        [[nodiscard]] auto add() -> std::size_t;
+        [[nodiscard]] auto add() -> Index
+        {
+            cpputil::always_assert(m_entries.size() < root_bit);
+            m_entries.push_back(root_bit);
+            return Index(m_entries.size() - 1);
+        }
 
-        // Find the representative of `x`. Compresses the path as it is traversed.
-        [[nodiscard]] auto find(std::size_t x) -> std::size_t;
+        // Find the representative of `x`. Shortens the path as it is traversed.
+        [[nodiscard]] auto find(Index const x) -> Index
+        {
+            return Index(find_root(to_entry(x)));
+        }
 
         // Find the representative of `x`.
-        [[nodiscard]] auto find_without_compressing(std::size_t x) const -> std::size_t;
+        [[nodiscard]] auto find_without_compressing(Index const x) const -> Index
+        {
+            std::uint32_t root = to_entry(x);
+            while (not is_root(m_entries.at(root))) {
+                root = m_entries.at(root);
+            }
+            return Index(root);
+        }
+
+        // Get the number of nodes in the set.
+        [[nodiscard]] auto size() const noexcept -> std::size_t
+        {
+            return m_entries.size();
+        }
+
+        // Start recording changes, so that they can be undone with `rollback`.
+        [[nodiscard]] auto snapshot() -> Snapshot
+        {
+            ++m_open_snapshots;
+            return Snapshot { .size = m_entries.size(), .undo_log_size = m_undo_log.size() };
+        }
+
+        // Undo every change made since `snapshot` was taken, including added nodes.
+        void rollback(Snapshot const snapshot)
+        {
+            cpputil::always_assert(snapshot.undo_log_size <= m_undo_log.size());
+            while (m_undo_log.size() != snapshot.undo_log_size) {
+                Undo const undo = m_undo_log.back();
+                m_undo_log.pop_back();
+                m_entries.at(undo.index) = undo.entry;
+            }
+            m_entries.resize(snapshot.size);
+            close_snapshot();
+        }
+
+        // Keep the changes made since `snapshot` was taken.
+        void commit(Snapshot const snapshot)
+        {
+            cpputil::always_assert(snapshot.undo_log_size <= m_undo_log.size());
+            close_snapshot();
+        }
     };
 
 } // namespace ki::utl
@@ -3,8 +3,15 @@
 
 #include <libutl/utilities.hpp>
 
+#ifndef KIELI_CHECKED_INDEXING
+#define KIELI_CHECKED_INDEXING 1
+#endif
+
 namespace ki::utl {
 
+    // Whether index accesses are bounds checked. Controlled by the CMake option of the same name.
+    inline constexpr bool checked_indexing = KIELI_CHECKED_INDEXING != 0;
+
     // A type that models `vector_index` can be used as the index type of `Index_vector`.
     template <typename Index>
     concept vector_index = requires(Index const index) {
@@ -25,7 +32,12 @@ namespace ki::utl {
         [[nodiscard]] constexpr auto get(this Vector_index const self)
             noexcept(cpputil::num::losslessly_convertible<Integral, std::size_t>) -> std::size_t
         {
-            return cpputil::num::safe_cast<std::size_t>(self.m_value);
+            if constexpr (checked_indexing) {
+                return cpputil::num::safe_cast<std::size_t>(self.m_value);
+            }
+            else {
+                return static_cast<std::size_t>(self.m_value);
+            }
         }
 
         auto operator==(Vector_index const& other) const -> bool = default;
@@ -39,7 +51,12 @@ namespace ki::utl {
     public:
         [[nodiscard]] constexpr auto operator[](this auto&& self, Index index) -> decltype(auto)
         {
-            return std::forward_like<decltype(self)>(self.underlying.at(index.get()));
+            if constexpr (checked_indexing) {
+                return std::forward_like<decltype(self)>(self.underlying.at(index.get()));
+            }
+            else {
+                return std::forward_like<decltype(self)>(self.underlying[index.get()]);
+            }
         }
 
         template <typename... Args>
@@ -49,6 +66,21 @@ namespace ki::utl {
             underlying.emplace_back(std::forward<Args>(args)...);
             return Index(underlying.size() - 1);
         }
+
+        [[nodiscard]] constexpr auto size() const noexcept -> std::size_t
+        {
+            return underlying.size();
+        }
+
+        [[nodiscard]] constexpr auto begin(this auto&& self) noexcept
+        {
+            return self.underlying.begin();
+        }
+
+        [[nodiscard]] constexpr auto end(this auto&& self) noexcept
+        {
+            return self.underlying.end();
+        }
     };
 
     struct Hash_vector_index {
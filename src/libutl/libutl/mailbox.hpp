@@ -5,37 +5,107 @@
 
 namespace ki::utl {
 
-    // Thread-safe queue.
+    // Thread-safe queue. Any number of threads may push, but only one thread may receive.
+    // Pushing is lock-free: messages are linked onto an atomic stack, which the receiver takes in
+    // a single exchange and reverses into arrival order.
     template <typename T>
     class Mailbox {
-        mutable std::mutex m_mutex;
-        std::queue<T>      m_queue;
+        struct Node {
+            T     mail;
+            Node* next {};
+        };
+
+        std::atomic<Node*> m_head { nullptr };
+        std::vector<T>     m_taken; // Owned by the receiver. The oldest message is last.
+
+        // Move every pushed message to `m_taken`, which must be empty.
+        auto take() -> bool
+        {
+            Node* node = m_head.exchange(nullptr, std::memory_order_acquire);
+            if (node == nullptr) {
+                return false;
+            }
+            while (node != nullptr) {
+                std::unique_ptr<Node> owner(node);
+                m_taken.push_back(std::move(node->mail));
+                node = node->next;
+            }
+            return true;
+        }
+
+        void move_taken(std::vector<T>& output)
+        {
+            std::ranges::move(m_taken | std::views::reverse, std::back_inserter(output));
+            m_taken.clear();
+        }
     public:
         Mailbox() = default;
 
+        Mailbox(Mailbox const&) = delete;
+
+        Mailbox(Mailbox&&) = delete;
+
+        auto operator=(Mailbox const&) -> Mailbox& = delete;
+
+        auto operator=(Mailbox&&) -> Mailbox& = delete;
+
+        ~Mailbox()
+        {
+            take();
+        }
+
+        // Check whether there are no messages. Only meaningful on the receiving thread.
         [[nodiscard]] auto is_empty() const -> bool
         {
-            std::scoped_lock _(m_mutex);
-            return m_queue.empty();
+            return m_taken.empty() and m_head.load(std::memory_order_acquire) == nullptr;
+        }
+
+        // Pop the first message, if there is one.
+        [[nodiscard]] auto try_pop() -> std::optional<T>
+        {
+            if (m_taken.empty() and not take()) {
+                return std::nullopt;
+            }
+            T mail = std::move(m_taken.back());
+            m_taken.pop_back();
+            return mail;
         }
 
-        [[nodiscard]] auto pop() -> std::optional<T>
+        // Block until the mailbox is not empty, then pop the first message.
+        [[nodiscard]] auto wait_pop() -> T
         {
-            std::scoped_lock _(m_mutex);
-            if (not m_queue.empty()) {
-                T mail = std::move(m_queue.front());
-                m_queue.pop();
-                return mail;
+            for (;;) {
+                if (auto mail = try_pop()) {
+                    return std::move(mail).value();
+                }
+                m_head.wait(nullptr, std::memory_order_acquire);
+            }
+        }
+
+        // Append every message to `output`, in arrival order.
+        void drain(std::vector<T>& output)
+        {
+            move_taken(output);
+            if (take()) {
+                move_taken(output);
             }
-            return std::nullopt;
         }
 
         template <typename... Args>
         void push(Args&&... args)
             requires std::is_constructible_v<T, Args...>
         {
-            std::scoped_lock _(m_mutex);
-            m_queue.emplace(std::forward<Args>(args)...);
+            Node* const node = std::make_unique<Node>(T(std::forward<Args>(args)...)).release();
+            Node*       head = m_head.load(std::memory_order_relaxed);
+            do {
+                node->next = head;
+            } while (not m_head.compare_exchange_weak(
+                head, node, std::memory_order_release, std::memory_order_relaxed));
+
+            // The receiver only sleeps when the stack is empty.
+            if (head == nullptr) {
+                m_head.notify_one();
+            }
         }
     };
 
@@ -0,0 +1,289 @@
+#ifndef KIELI_LIBUTL_SMALL_VECTOR
+#define KIELI_LIBUTL_SMALL_VECTOR
+
+#include <libutl/utilities.hpp>
+
+namespace ki::utl {
+
+    // Vector that stores up to `inline_capacity` elements inside the object itself, and only
+    // allocates once it grows beyond that. Suited for child lists that are usually tiny.
+    template <typename T, std::size_t inline_capacity>
+    class Small_vector {
+        static_assert(inline_capacity != 0);
+        static_assert(inline_capacity <= std::numeric_limits<std::uint32_t>::max());
+
+        T*            m_data;
+        std::uint32_t m_size {};
+        std::uint32_t m_capacity { inline_capacity };
+
+        alignas(T) std::array<std::byte, sizeof(T) * inline_capacity> m_storage;
+
+        [[nodiscard]] auto inline_data() noexcept -> T*
+        {
+            return reinterpret_cast<T*>(m_storage.data()); // NOLINT(*-reinterpret-cast)
+        }
+
+        void reallocate(std::size_t const capacity)
+        {
+            auto const new_capacity = cpputil::num::safe_cast<std::uint32_t>(capacity);
+
+            T* data = std::allocator<T> {}.allocate(new_capacity);
+            std::uninitialized_move(begin(), end(), data);
+            std::destroy(begin(), end());
+            release();
+
+            m_data     = data;
+            m_capacity = new_capacity;
+        }
+
+        void grow()
+        {
+            reallocate(static_cast<std::size_t>(m_capacity) * 2);
+        }
+
+        void release() noexcept
+        {
+            if (not is_inline()) {
+                std::allocator<T> {}.deallocate(m_data, m_capacity);
+            }
+        }
+
+        void adopt(Small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            if (other.is_inline()) {
+                m_data     = inline_data();
+                m_capacity = inline_capacity;
+                std::uninitialized_move(other.begin(), other.end(), m_data);
+                m_size = other.m_size;
+                other.clear();
+            }
+            else {
+                m_data     = std::exchange(other.m_data, other.inline_data());
+                m_size     = std::exchange(other.m_size, 0);
+                m_capacity = std::exchange(other.m_capacity, inline_capacity);
+            }
+        }
+    public:
+        using value_type      = T;
+        using size_type       = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference       = T&;
+        using const_reference = T const&;
+        using pointer         = T*;
+        using const_pointer   = T const*;
+        using iterator        = T*;
+        using const_iterator  = T const*;
+
+        Small_vector() noexcept : m_data(inline_data()) {}
+
+        template <std::input_iterator It, std::sentinel_for<It> Sentinel>
+        Small_vector(It first, Sentinel const last) : Small_vector()
+        {
+            if constexpr (std::sized_sentinel_for<Sentinel, It>) {
+                reserve(static_cast<std::size_t>(last - first));
+            }
+            for (; first != last; ++first) {
+                emplace_back(*first);
+            }
+        }
+
+        template <std::ranges::input_range Range>
+        Small_vector(std::from_range_t, Range&& range)
+            : Small_vector(std::ranges::begin(range), std::ranges::end(range))
+        {}
+
+        Small_vector(std::initializer_list<T> const list) : Small_vector(list.begin(), list.end())
+        {}
+
+        Small_vector(Small_vector const& other) : Small_vector(other.begin(), other.end()) {}
+
+        Small_vector(Small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            adopt(std::move(other));
+        }
+
+        auto operator=(Small_vector const& other) -> Small_vector&
+        {
+            if (this != &other) {
+                clear();
+                reserve(other.size());
+                std::uninitialized_copy(other.begin(), other.end(), m_data);
+                m_size = other.m_size;
+            }
+            return *this;
+        }
+
+        auto operator=(Small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+            -> Small_vector&
+        {
+            if (this != &other) {
+                clear();
+                release();
+                adopt(std::move(other));
+            }
+            return *this;
+        }
+
+        ~Small_vector()
+        {
+            clear();
+            release();
+        }
+
+        template <typename... Args>
+        auto emplace_back(Args&&... args) -> T&
+        {
+            if (m_size == m_capacity) {
+                // Construct first, in case `args` refers to an element of this vector.
+                T value(std::forward<Args>(args)...);
+                grow();
+                return *std::construct_at(m_data + m_size++, std::move(value));
+            }
+            return *std::construct_at(m_data + m_size++, std::forward<Args>(args)...);
+        }
+
+        void push_back(T const& value)
+        {
+            emplace_back(value);
+        }
+
+        void push_back(T&& value)
+        {
+            emplace_back(std::move(value));
+        }
+
+        auto insert(const_iterator const position, T value) -> iterator
+        {
+            auto const index = static_cast<std::size_t>(position - begin());
+            emplace_back(std::move(value));
+            std::rotate(begin() + index, end() - 1, end());
+            return begin() + index;
+        }
+
+        void pop_back()
+        {
+            cpputil::always_assert(not empty());
+            std::destroy_at(m_data + --m_size);
+        }
+
+        void clear() noexcept
+        {
+            std::destroy(begin(), end());
+            m_size = 0;
+        }
+
+        void reserve(std::size_t const capacity)
+        {
+            if (capacity > m_capacity) {
+                reallocate(capacity);
+            }
+        }
+
+        // Check whether the elements are stored inside the object.
+        [[nodiscard]] auto is_inline() const noexcept -> bool
+        {
+            return m_data == reinterpret_cast<T const*>(m_storage.data()); // NOLINT
+        }
+
+        [[nodiscard]] auto at(std::size_t const index) -> T&
+        {
+            if (index >= size()) {
+                throw std::out_of_range("utl::Small_vector::at");
+            }
+            return m_data[index];
+        }
+
+        [[nodiscard]] auto at(std::size_t const index) const -> T const&
+        {
+            if (index >= size()) {
+                throw std::out_of_range("utl::Small_vector::at");
+            }
+            return m_data[index];
+        }
+
+        [[nodiscard]] auto operator[](std::size_t const index) noexcept -> T&
+        {
+            return m_data[index];
+        }
+
+        [[nodiscard]] auto operator[](std::size_t const index) const noexcept -> T const&
+        {
+            return m_data[index];
+        }
+
+        [[nodiscard]] auto front() noexcept -> T&
+        {
+            return m_data[0];
+        }
+
+        [[nodiscard]] auto front() const noexcept -> T const&
+        {
+            return m_data[0];
+        }
+
+        [[nodiscard]] auto back() noexcept -> T&
+        {
+            return m_data[m_size - 1];
+        }
+
+        [[nodiscard]] auto back() const noexcept -> T const&
+        {
+            return m_data[m_size - 1];
+        }
+
+        [[nodiscard]] auto data() noexcept -> T*
+        {
+            return m_data;
+        }
+
+        [[nodiscard]] auto data() const noexcept -> T const*
+        {
+            return m_data;
+        }
+
+        [[nodiscard]] auto size() const noexcept -> std::size_t
+        {
+            return m_size;
+        }
+
+        [[nodiscard]] auto capacity() const noexcept -> std::size_t
+        {
+            return m_capacity;
+        }
+
+        [[nodiscard]] auto empty() const noexcept -> bool
+        {
+            return m_size == 0;
+        }
+
+        [[nodiscard]] auto begin() noexcept -> iterator
+        {
+            return m_data;
+        }
+
+        [[nodiscard]] auto begin() const noexcept -> const_iterator
+        {
+            return m_data;
+        }
+
+        [[nodiscard]] auto end() noexcept -> iterator
+        {
+            return m_data + m_size;
+        }
+
+        [[nodiscard]] auto end() const noexcept -> const_iterator
+        {
+            return m_data + m_size;
+        }
+
+        [[nodiscard]] friend auto operator==(Small_vector const& lhs, Small_vector const& rhs)
+            -> bool
+            requires std::equality_comparable<T>
+        {
+            return std::ranges::equal(lhs, rhs);
+        }
+    };
+
+} // namespace ki::utl
+
+#endif // KIELI_LIBUTL_SMALL_VECTOR
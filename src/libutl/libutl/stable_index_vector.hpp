@@ -0,0 +1,207 @@
+#ifndef KIELI_LIBUTL_STABLE_INDEX_VECTOR
+#define KIELI_LIBUTL_STABLE_INDEX_VECTOR
+
+#include <libutl/utilities.hpp>
+#include <libutl/index_vector.hpp>
+
+namespace ki::utl {
+
+    // Like `Index_vector`, but elements are stored in chunks that are never reallocated, so
+    // references remain valid across `push`. Chunk `k` holds `first_chunk_size << k` elements.
+    // A single thread may push while other threads read elements that have already been pushed.
+    template <vector_index Index, typename T>
+    class [[nodiscard]] Stable_index_vector {
+        static constexpr std::size_t first_chunk_bits = 6;
+        static constexpr std::size_t first_chunk_size = std::size_t { 1 } << first_chunk_bits;
+        static constexpr std::size_t chunk_count      = 32;
+
+        std::array<std::atomic<T*>, chunk_count> m_chunks {};
+        std::atomic<std::size_t>                 m_size;
+
+        struct Location {
+            std::size_t chunk {};
+            std::size_t offset {};
+        };
+
+        [[nodiscard]] static constexpr auto chunk_size(std::size_t const chunk) noexcept
+            -> std::size_t
+        {
+            return first_chunk_size << chunk;
+        }
+
+        [[nodiscard]] static constexpr auto locate(std::size_t const index) noexcept -> Location
+        {
+            std::size_t const chunk = std::bit_width((index >> first_chunk_bits) + 1) - 1;
+            return Location {
+                .chunk  = chunk,
+                .offset = index + first_chunk_size - chunk_size(chunk),
+            };
+        }
+
+        [[nodiscard]] auto element(std::size_t const index) const noexcept -> T&
+        {
+            auto const [chunk, offset] = locate(index);
+            return m_chunks[chunk].load(std::memory_order_acquire)[offset];
+        }
+
+        [[nodiscard]] auto checked_element(std::size_t const index) const -> T&
+        {
+            if constexpr (checked_indexing) {
+                if (index >= size()) {
+                    throw std::out_of_range("utl::Stable_index_vector::operator[]");
+                }
+            }
+            return element(index);
+        }
+
+        void release() noexcept
+        {
+            std::size_t remaining = m_size.exchange(0, std::memory_order_relaxed);
+            for (std::size_t chunk = 0; chunk != chunk_count; ++chunk) {
+                T* const data = m_chunks[chunk].exchange(nullptr, std::memory_order_relaxed);
+                if (data == nullptr) {
+                    break;
+                }
+                std::size_t const count = std::min(remaining, chunk_size(chunk));
+                std::destroy_n(data, count);
+                std::allocator<T> {}.deallocate(data, chunk_size(chunk));
+                remaining -= count;
+            }
+        }
+
+        void adopt(Stable_index_vector& other) noexcept
+        {
+            for (std::size_t chunk = 0; chunk != chunk_count; ++chunk) {
+                m_chunks[chunk].store(
+                    other.m_chunks[chunk].exchange(nullptr, std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+            }
+            m_size.store(other.m_size.exchange(0, std::memory_order_relaxed));
+        }
+
+        template <bool is_const>
+        class Iterator {
+            using Vector
+                = std::conditional_t<is_const, Stable_index_vector const, Stable_index_vector>;
+            using Reference = std::conditional_t<is_const, T const&, T&>;
+
+            Vector*     m_vector {};
+            std::size_t m_index {};
+        public:
+            using value_type      = T;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() = default;
+
+            Iterator(Vector* const vector, std::size_t const index) noexcept
+                : m_vector(vector)
+                , m_index(index)
+            {}
+
+            [[nodiscard]] auto operator*() const noexcept -> Reference
+            {
+                return m_vector->element(m_index);
+            }
+
+            auto operator++() noexcept -> Iterator&
+            {
+                ++m_index;
+                return *this;
+            }
+
+            auto operator++(int) noexcept -> Iterator
+            {
+                return Iterator(m_vector, m_index++);
+            }
+
+            auto operator==(Iterator const& other) const noexcept -> bool
+            {
+                return m_index == other.m_index;
+            }
+        };
+    public:
+        using iterator       = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        Stable_index_vector() noexcept : m_size(0) {}
+
+        Stable_index_vector(Stable_index_vector const&) = delete;
+
+        Stable_index_vector(Stable_index_vector&& other) noexcept : m_size(0)
+        {
+            adopt(other);
+        }
+
+        auto operator=(Stable_index_vector const&) -> Stable_index_vector& = delete;
+
+        auto operator=(Stable_index_vector&& other) noexcept -> Stable_index_vector&
+        {
+            if (this != &other) {
+                release();
+                adopt(other);
+            }
+            return *this;
+        }
+
+        ~Stable_index_vector()
+        {
+            release();
+        }
+
+        [[nodiscard]] auto operator[](this auto&& self, Index index) -> decltype(auto)
+        {
+            return std::forward_like<decltype(self)>(self.checked_element(index.get()));
+        }
+
+        // Append a new element. Must not be called concurrently with itself.
+        template <typename... Args>
+        [[nodiscard]] auto push(Args&&... args) -> Index
+            requires std::is_constructible_v<T, Args...>
+        {
+            std::size_t const index = m_size.load(std::memory_order_relaxed);
+            Index const       id(index);
+
+            auto const [chunk, offset] = locate(index);
+            cpputil::always_assert(chunk < chunk_count);
+
+            T* data = m_chunks[chunk].load(std::memory_order_relaxed);
+            if (data == nullptr) {
+                data = std::allocator<T> {}.allocate(chunk_size(chunk));
+                m_chunks[chunk].store(data, std::memory_order_release);
+            }
+            std::construct_at(data + offset, std::forward<Args>(args)...);
+
+            // Publish the element to readers on other threads.
+            m_size.store(index + 1, std::memory_order_release);
+            return id;
+        }
+
+        [[nodiscard]] auto size() const noexcept -> std::size_t
+        {
+            return m_size.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] auto begin() noexcept -> iterator
+        {
+            return iterator(this, 0);
+        }
+
+        [[nodiscard]] auto begin() const noexcept -> const_iterator
+        {
+            return const_iterator(this, 0);
+        }
+
+        [[nodiscard]] auto end() noexcept -> iterator
+        {
+            return iterator(this, size());
+        }
+
+        [[nodiscard]] auto end() const noexcept -> const_iterator
+        {
+            return const_iterator(this, size());
+        }
+    };
+
+} // namespace ki::utl
+
+#endif // KIELI_LIBUTL_STABLE_INDEX_VECTOR
@@ -1,28 +1,212 @@
 #include <libutl/utilities.hpp>
 #include <libutl/string_pool.hpp>
 
-auto ki::utl::String_pool::make(std::string owned) -> String_id
+namespace {
+    constexpr std::size_t shard_bits         = 4;
+    constexpr std::size_t shard_count        = 1UZ << shard_bits;
+    constexpr std::size_t default_chunk_size = 64 * 1024;
+    constexpr std::size_t initial_slot_count = 256;
+
+    struct Record {
+        std::string_view string;
+        std::size_t      hash {};
+    };
+
+    // Append-only record storage with stable addresses, so that readers never observe a
+    // reallocation. Block `k` holds `first_block_size << k` records.
+    class Record_table {
+        static constexpr std::size_t first_block_size = 64;
+        static constexpr std::size_t block_count      = 32;
+
+        std::array<std::atomic<Record*>, block_count> m_blocks {};
+
+        static auto locate(std::size_t const index) noexcept -> std::pair<std::size_t, std::size_t>
+        {
+            auto const block = std::bit_width(index / first_block_size + 1) - 1;
+            return { block, index - first_block_size * ((1UZ << block) - 1) };
+        }
+    public:
+        Record_table() = default;
+
+        Record_table(Record_table const&)                    = delete;
+        auto operator=(Record_table const&) -> Record_table& = delete;
+
+        ~Record_table()
+        {
+            for (auto& block : m_blocks) {
+                delete[] block.load(std::memory_order_relaxed);
+            }
+        }
+
+        [[nodiscard]] auto at(std::size_t const index) const -> Record const&
+        {
+            auto const [block, offset] = locate(index);
+            return m_blocks.at(block).load(std::memory_order_acquire)[offset];
+        }
+
+        // Must only be called by one thread at a time.
+        void put(std::size_t const index, Record const record)
+        {
+            auto const [block, offset] = locate(index);
+            auto*      data            = m_blocks.at(block).load(std::memory_order_relaxed);
+            if (data == nullptr) {
+                data = new Record[first_block_size << block];
+                m_blocks.at(block).store(data, std::memory_order_release);
+            }
+            data[offset] = record;
+        }
+    };
+
+    // Open-addressing table of record indices, plus one. Zero marks an empty slot.
+    struct Slot_table {
+        std::size_t                                   mask {};
+        std::unique_ptr<std::atomic<std::uint32_t>[]> slots;
+    };
+
+    auto make_slot_table(std::size_t const capacity) -> std::unique_ptr<Slot_table>
+    {
+        cpputil::always_assert(std::has_single_bit(capacity));
+        auto table   = std::make_unique<Slot_table>();
+        table->mask  = capacity - 1;
+        table->slots = std::make_unique<std::atomic<std::uint32_t>[]>(capacity);
+        return table;
+    }
+
+    auto shard_index(std::size_t const hash) noexcept -> std::size_t
+    {
+        // Use the high bits, since the low bits select the slot within the shard.
+        return hash >> (std::numeric_limits<std::size_t>::digits - shard_bits);
+    }
+} // namespace
+
+struct ki::utl::String_pool::Shard {
+    std::atomic<Slot_table*>                 current; // Read without locking.
+    std::vector<std::unique_ptr<Slot_table>> tables;  // Current and retired tables.
+    Record_table                             records; // Written only under `mutex`.
+    std::size_t                              count {};
+    std::vector<std::unique_ptr<char[]>>     chunks;
+    std::size_t                              chunk_size {};
+    std::size_t                              chunk_used {};
+    std::mutex                               mutex;
+
+    // Find the record index of `string` in `table`, without locking.
+    auto find(Slot_table const* table, std::string_view string, std::size_t hash) const
+        -> std::optional<std::size_t>
+    {
+        if (table == nullptr) {
+            return std::nullopt;
+        }
+        for (auto slot = hash & table->mask;; slot = (slot + 1) & table->mask) {
+            auto const value = table->slots[slot].load(std::memory_order_acquire);
+            if (value == 0) {
+                return std::nullopt;
+            }
+            auto const& record = records.at(value - 1);
+            if (record.hash == hash and record.string == string) {
+                return value - 1;
+            }
+        }
+    }
+
+    void place(Slot_table& table, std::size_t const index)
+    {
+        auto slot = records.at(index).hash & table.mask;
+        while (table.slots[slot].load(std::memory_order_relaxed) != 0) {
+            slot = (slot + 1) & table.mask;
+        }
+        table.slots[slot].store(
+            cpputil::num::safe_cast<std::uint32_t>(index + 1), std::memory_order_release);
+    }
+
+    // Replace the current table with a larger one. Readers may keep using the old table.
+    void grow()
+    {
+        auto const capacity = tables.empty() ? initial_slot_count : (tables.back()->mask + 1) * 2;
+        auto       table    = make_slot_table(capacity);
+        for (std::size_t index = 0; index != count; ++index) {
+            place(*table, index);
+        }
+        current.store(table.get(), std::memory_order_release);
+        tables.push_back(std::move(table));
+    }
+
+    auto copy(std::string_view const string) -> std::string_view
+    {
+        if (chunks.empty() or chunk_size - chunk_used < string.size()) {
+            chunk_size = std::max(default_chunk_size, string.size());
+            chunk_used = 0;
+            chunks.push_back(std::make_unique_for_overwrite<char[]>(chunk_size));
+        }
+        char* const data = chunks.back().get() + chunk_used;
+        std::ranges::copy(string, data);
+        chunk_used += string.size();
+        return std::string_view(data, string.size());
+    }
+
+    auto insert(std::string_view const string, std::size_t const hash) -> std::size_t
+    {
+        std::scoped_lock const lock(mutex);
+
+        // Another thread may have inserted the string since the unlocked lookup.
+        if (auto const index = find(current.load(std::memory_order_relaxed), string, hash)) {
+            return index.value();
+        }
+
+        // Keep the table at most half full.
+        if (tables.empty() or (count + 1) * 2 > tables.back()->mask + 1) {
+            grow();
+        }
+
+        auto const index = count++;
+        records.put(index, Record { .string = copy(string), .hash = hash });
+        place(*tables.back(), index);
+        return index;
+    }
+};
+
+ki::utl::String_pool::String_pool() : m_shards(std::make_unique<Shard[]>(shard_count)) {}
+
+ki::utl::String_pool::String_pool(String_pool&&) noexcept = default;
+
+auto ki::utl::String_pool::operator=(String_pool&&) noexcept -> String_pool& = default;
+
+ki::utl::String_pool::~String_pool() = default;
+
+auto ki::utl::String_pool::make(std::string_view const string, std::size_t const precomputed_hash)
+    -> String_id
 {
-    if (auto const it = m_map.find(owned); it != m_map.end()) {
-        return it->second;
+    assert(precomputed_hash == hash(string));
+
+    auto const shard = shard_index(precomputed_hash);
+    auto&      state = m_shards[shard];
+
+    auto index = state.find(state.current.load(std::memory_order_acquire), string, precomputed_hash);
+    if (not index.has_value()) {
+        index = state.insert(string, precomputed_hash);
     }
-    auto const id = m_vec.push(owned);
-    m_map.insert_or_assign(std::move(owned), id);
-    return id;
+    return String_id(index.value() * shard_count + shard);
 }
 
-auto ki::utl::String_pool::make(std::string_view borrowed) -> String_id
+auto ki::utl::String_pool::make(std::string_view const string) -> String_id
 {
-    if (auto const it = m_map.find(borrowed); it != m_map.end()) {
-        return it->second;
-    }
-    std::string copy(borrowed);
-    auto const  id = m_vec.push(copy);
-    m_map.insert_or_assign(std::move(copy), id);
-    return id;
+    return make(string, hash(string));
 }
 
-auto ki::utl::String_pool::get(String_id id) const -> std::string_view
+auto ki::utl::String_pool::get(String_id const id) const -> std::string_view
 {
-    return m_vec[id];
+    return m_shards[id.get() % shard_count].records.at(id.get() / shard_count).string;
+}
+
+auto ki::utl::String_pool::hash(std::string_view const string) noexcept -> std::size_t
+{
+    // FNV-1a, followed by a finalizer that mixes the low bits into the high bits that select the
+    // shard. Unlike `std::hash`, this gives the same ids with every standard library.
+    std::uint64_t hash = 0xcbf2'9ce4'8422'2325;
+    for (char const character : string) {
+        hash = (hash ^ static_cast<unsigned char>(character)) * 0x100'0000'01b3;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51'afd7'ed55'8ccd;
+    hash ^= hash >> 33;
+    return static_cast<std::size_t>(hash);
 }
@@ -10,14 +10,32 @@ namespace ki::utl {
         using Vector_index::Vector_index;
     };
 
+    // Thread-safe string interner. Strings are distributed over shards by hash, and each shard
+    // copies string bytes once into a chunked character arena. Looking up a string that has
+    // already been interned takes no locks; interning a new string locks only its shard.
+    // Ids are deterministic for a given order of first insertions, so they are reproducible when
+    // strings are first inserted by a single thread. When several threads insert new strings
+    // concurrently, ids depend on scheduling, and must not determine any observable ordering.
     class String_pool {
-        using Hash = Transparent_hash<std::string_view>;
-        std::unordered_map<std::string, String_id, Hash, std::equal_to<>> m_map;
-        Index_vector<String_id, std::string>                              m_vec;
+        struct Shard;
+        std::unique_ptr<Shard[]> m_shards;
     public:
-        [[nodiscard]] auto make(std::string owned) -> String_id;
-        [[nodiscard]] auto make(std::string_view borrowed) -> String_id;
+        String_pool();
+        String_pool(String_pool&&) noexcept;
+        auto operator=(String_pool&&) noexcept -> String_pool&;
+        ~String_pool();
+
+        // Intern `string`, whose hash as computed by `String_pool::hash` is `precomputed_hash`.
+        [[nodiscard]] auto make(std::string_view string, std::size_t precomputed_hash) -> String_id;
+
+        // Intern `string`.
+        [[nodiscard]] auto make(std::string_view string) -> String_id;
+
+        // The returned view remains valid for the lifetime of the pool.
         [[nodiscard]] auto get(String_id id) const -> std::string_view;
+
+        // Hash a string for use with `make`. The hash does not depend on the standard library.
+        [[nodiscard]] static auto hash(std::string_view string) noexcept -> std::size_t;
     };
 
 } // namespace ki::utl
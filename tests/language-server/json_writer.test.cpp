@@ -0,0 +1,46 @@
+#include <libutl/utilities.hpp>
+#include <cppunittest/unittest.hpp>
+#include <language-server/json_writer.hpp>
+
+using namespace ki;
+
+UNITTEST("json writer separators")
+{
+    lsp::Json_writer writer;
+    writer.begin_object();
+    writer.key("a");
+    writer.numbers(std::vector<std::uint32_t> { 1, 2, 3 });
+    writer.key("b");
+    writer.begin_array();
+    writer.null();
+    writer.boolean(true);
+    writer.number(-5);
+    writer.end_array();
+    writer.end_object();
+    REQUIRE_EQUAL(writer.view(), R"({"a":[1,2,3],"b":[null,true,-5]})");
+}
+
+UNITTEST("json writer string escapes")
+{
+    lsp::Json_writer writer;
+    writer.string("\"\\\n\t\x01x");
+    REQUIRE_EQUAL(writer.view(), R"("\"\\\n\t\u0001x")");
+}
+
+UNITTEST("json writer rollback")
+{
+    lsp::Json_writer writer;
+    writer.begin_array();
+    writer.number(1);
+    auto const checkpoint = writer.checkpoint();
+    writer.begin_object();
+    writer.key("x");
+    writer.rollback(checkpoint);
+    writer.number(2);
+    writer.end_array();
+    REQUIRE_EQUAL(writer.view(), "[1,2]");
+
+    writer.clear();
+    writer.number(3);
+    REQUIRE_EQUAL(writer.view(), "3");
+}
@@ -144,3 +144,214 @@ UNITTEST("document synchronization")
 
     REQUIRE(not lsp::rpc::read_message(output).has_value());
 }
+
+UNITTEST("incremental analysis")
+{
+    auto const change = [](int version, int line, int begin, int end, std::string_view text) {
+        return std::format(
+            R"({{
+                "jsonrpc": "2.0",
+                "method": "textDocument/didChange",
+                "params": {{
+                    "textDocument": {{ "uri": "file://test-uri", "version": {0} }},
+                    "contentChanges": [{{
+                        "range": {{
+                            "start": {{ "line": {1}, "character": {2} }},
+                            "end": {{ "line": {1}, "character": {3} }}
+                        }},
+                        "text": "{4}"
+                    }}]
+                }}
+            }})",
+            version,
+            line,
+            begin,
+            end,
+            text);
+    };
+
+    // Open a document, apply `changes`, and return the last published diagnostics. The reader
+    // thread receives every change up front, so the analyses of all but the last change may be
+    // cancelled, and only the final diagnostics are deterministic.
+    auto const final_diagnostics = [](std::vector<std::string> const& changes) {
+        std::stringstream input;
+        std::stringstream output;
+
+        lsp::rpc::write_message(input, R"({"jsonrpc":"2.0","id":0,"method":"initialize"})");
+        lsp::rpc::write_message(
+            input,
+            R"({
+                "jsonrpc": "2.0",
+                "method": "textDocument/didOpen",
+                "params": {
+                    "textDocument": {
+                        "uri": "file://test-uri",
+                        "text": "fn _a(): typeof(0.0) { 0.0 }\nfn _b(): typeof(0.0) { _a() }",
+                        "languageId": "kieli",
+                        "version": 0
+                    }
+                }
+            })"sv);
+        for (std::string const& change : changes) {
+            lsp::rpc::write_message(input, change);
+        }
+        lsp::rpc::write_message(input, R"({"jsonrpc":"2.0","id":1,"method":"shutdown"})");
+        lsp::rpc::write_message(input, R"({"jsonrpc":"2.0","method":"exit"})");
+
+        REQUIRE_EQUAL(0, lsp::run_server(lsp::default_server_config(), input, output));
+
+        std::optional<lsp::Json> diagnostics;
+        while (auto message = lsp::rpc::read_message(output)) {
+            auto object
+                = cpputil::json::decode<lsp::Json_config>(message.value()).value().as_object();
+            if (object.contains("params")) {
+                diagnostics = object.at("params").as_object().at("diagnostics");
+            }
+        }
+        REQUIRE(diagnostics.has_value());
+        return std::move(diagnostics).value().as_array();
+    };
+
+    // Introduce a type error in the body of the first function.
+    REQUIRE(not final_diagnostics({ change(1, 0, 23, 26, "true") }).empty());
+
+    // The diagnostics of the edited definition should be replaced when the error is fixed.
+    REQUIRE(final_diagnostics({ change(1, 0, 23, 26, "true"), change(2, 0, 23, 27, "0.0") })
+                .empty());
+
+    // Insert a line before both functions, then introduce a type error in the second one.
+    // The diagnostics should be reported at the shifted position.
+    auto const diagnostics = final_diagnostics({
+        change(1, 0, 23, 26, "true"),
+        change(2, 0, 23, 27, "0.0"),
+        change(3, 0, 0, 0, "\\n"),
+        change(4, 2, 23, 27, "true"),
+    });
+    REQUIRE(not diagnostics.empty());
+    for (auto const& diagnostic : diagnostics) {
+        auto const& start = diagnostic.as_object().at("range").as_object().at("start");
+        CHECK_EQUAL(start.as_object().at("line"), lsp::Json { 2 });
+    }
+}
+
+UNITTEST("semantic tokens")
+{
+    std::stringstream input;
+    std::stringstream output;
+
+    lsp::rpc::write_message(input, R"({"jsonrpc":"2.0","id":0,"method":"initialize"})");
+    lsp::rpc::write_message(
+        input,
+        R"({
+            "jsonrpc": "2.0",
+            "method": "textDocument/didOpen",
+            "params": {
+                "textDocument": {
+                    "uri": "file://test-uri",
+                    "text": "fn _a(): typeof(0.0) { 0.0 }",
+                    "languageId": "kieli",
+                    "version": 0
+                }
+            }
+        })"sv);
+    lsp::rpc::write_message(
+        input,
+        R"({
+            "jsonrpc": "2.0",
+            "id": 1,
+            "method": "textDocument/semanticTokens/full",
+            "params": { "textDocument": { "uri": "file://test-uri" } }
+        })"sv);
+
+    // Rename the function, which changes the length of one token.
+    lsp::rpc::write_message(
+        input,
+        R"({
+            "jsonrpc": "2.0",
+            "method": "textDocument/didChange",
+            "params": {
+                "textDocument": { "uri": "file://test-uri", "version": 1 },
+                "contentChanges": [{
+                    "range": {
+                        "start": { "line": 0, "character": 3 },
+                        "end": { "line": 0, "character": 5 }
+                    },
+                    "text": "_abc"
+                }]
+            }
+        })"sv);
+    lsp::rpc::write_message(
+        input,
+        R"({
+            "jsonrpc": "2.0",
+            "id": 2,
+            "method": "textDocument/semanticTokens/full/delta",
+            "params": { "textDocument": { "uri": "file://test-uri" }, "previousResultId": "0" }
+        })"sv);
+    lsp::rpc::write_message(
+        input,
+        R"({
+            "jsonrpc": "2.0",
+            "id": 3,
+            "method": "textDocument/semanticTokens/range",
+            "params": {
+                "textDocument": { "uri": "file://test-uri" },
+                "range": {
+                    "start": { "line": 0, "character": 0 },
+                    "end": { "line": 0, "character": 3 }
+                }
+            }
+        })"sv);
+
+    lsp::rpc::write_message(
+        input,
+        R"({
+            "jsonrpc": "2.0",
+            "id": 4,
+            "method": "textDocument/semanticTokens/full",
+            "params": { "textDocument": { "uri": "file://test-uri" } }
+        })"sv);
+
+    lsp::rpc::write_message(input, R"({"jsonrpc":"2.0","id":5,"method":"shutdown"})");
+    lsp::rpc::write_message(input, R"({"jsonrpc":"2.0","method":"exit"})");
+
+    REQUIRE_EQUAL(0, lsp::run_server(lsp::default_server_config(), input, output));
+
+    std::vector<lsp::Json::Object> replies;
+    while (auto message = lsp::rpc::read_message(output)) {
+        auto object = cpputil::json::decode<lsp::Json_config>(message.value()).value().as_object();
+        if (object.contains("id")) {
+            replies.push_back(std::move(object));
+        }
+    }
+    auto const result = [&](int id) {
+        auto const it = std::ranges::find_if(replies, [&](lsp::Json::Object const& reply) {
+            return reply.at("id") == lsp::Json { id };
+        });
+        REQUIRE(it != replies.end());
+        return it->at("result").as_object();
+    };
+
+    auto const full = result(1);
+    REQUIRE_EQUAL(full.at("resultId"), lsp::Json { "0" });
+    REQUIRE(not full.at("data").as_array().empty());
+
+    // Applying the delta to the previous tokens should give the current tokens.
+    auto const delta = result(2);
+    REQUIRE_EQUAL(delta.at("resultId"), lsp::Json { "1" });
+    auto const& edits = delta.at("edits").as_array();
+    REQUIRE_EQUAL(edits.size(), 1UZ);
+
+    auto const& edit   = edits.front().as_object();
+    auto const  start  = static_cast<std::ptrdiff_t>(lsp::as_unsigned(edit.at("start")));
+    auto const  count  = static_cast<std::ptrdiff_t>(lsp::as_unsigned(edit.at("deleteCount")));
+    auto        tokens = full.at("data").as_array();
+    tokens.erase(tokens.begin() + start, tokens.begin() + start + count);
+    tokens.insert_range(tokens.begin() + start, edit.at("data").as_array());
+    REQUIRE_EQUAL(lsp::Json { tokens }, result(4).at("data"));
+
+    // Only the `fn` keyword is in the requested range.
+    auto const& range = result(3).at("data").as_array();
+    REQUIRE_EQUAL(range.size(), 5UZ);
+    REQUIRE_EQUAL(range.at(2), lsp::Json { 2 });
+}
@@ -19,3 +19,34 @@ UNITTEST("RPC communication")
 
     REQUIRE(not lsp::rpc::read_message(stream).has_value());
 }
+
+UNITTEST("RPC buffered reader")
+{
+    std::stringstream stream;
+
+    lsp::rpc::write_message(stream, "hello");
+    stream << "Content-Type: application/vscode-jsonrpc; charset=utf-8\r\n";
+    lsp::rpc::write_message(stream, std::string(10'000, 'x'));
+    lsp::rpc::write_message(stream, "");
+    stream << "Content-Length: 10\r\n\r\nshort";
+
+    lsp::rpc::Reader reader(stream);
+
+    REQUIRE_EQUAL(reader.read().value(), "hello");
+    REQUIRE_EQUAL(reader.read().value(), std::string(10'000, 'x'));
+    REQUIRE_EQUAL(reader.read().value(), "");
+    REQUIRE_EQUAL(reader.read().error(), "Premature end of input");
+}
+
+UNITTEST("RPC buffered reader header errors")
+{
+    std::stringstream stream;
+    stream << "Content-Type: text\r\n\r\n";
+    REQUIRE_EQUAL(lsp::rpc::Reader(stream).read().error(), "Missing Content-Length header");
+
+    stream.str("Content-Length: 5x\r\n\r\nhello");
+    REQUIRE_EQUAL(lsp::rpc::Reader(stream).read().error(), "Missing content length");
+
+    stream.str("Content-Length: 5\n\nhello");
+    REQUIRE_EQUAL(lsp::rpc::Reader(stream).read().error(), "Header line not terminated by CRLF");
+}
@@ -0,0 +1,32 @@
+#include <libutl/utilities.hpp>
+#include <cppunittest/unittest.hpp>
+#include <libcompiler/db.hpp>
+
+using namespace ki;
+
+UNITTEST("ki::db::cancel")
+{
+    auto token = db::cancellation_token();
+    auto copy  = token;
+
+    REQUIRE(not db::is_cancelled(token));
+    REQUIRE(not db::is_cancelled(copy));
+
+    db::cancel(copy);
+
+    REQUIRE(db::is_cancelled(token));
+    REQUIRE(db::is_cancelled(copy));
+    REQUIRE_THROWS_AS(db::Job_cancelled, db::check_cancellation(token));
+}
+
+UNITTEST("ki::db::cancellation_token time budget")
+{
+    REQUIRE(db::is_cancelled(db::cancellation_token(0ms)));
+    REQUIRE(not db::is_cancelled(db::cancellation_token(1h)));
+}
+
+UNITTEST("default cancellation token")
+{
+    REQUIRE(not db::is_cancelled(db::Cancellation_token {}));
+    REQUIRE(not db::is_cancelled(db::database({}).cancellation));
+}
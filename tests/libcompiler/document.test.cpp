@@ -36,16 +36,114 @@ UNITTEST("ki::db::text_range")
 
 UNITTEST("ki::db::edit_text")
 {
-    std::string text = "lo";
+    auto doc = document("lo", Ownership::Client);
 
-    edit_text(text, range(0, 0, 0, 0), "hel");
-    REQUIRE_EQUAL(text, "hello");
+    edit_text(doc, range(0, 0, 0, 0), "hel");
+    REQUIRE_EQUAL(doc.text, "hello");
 
-    edit_text(text, range(0, 5, 0, 5), ", world");
-    REQUIRE_EQUAL(text, "hello, world");
+    edit_text(doc, range(0, 5, 0, 5), ", world");
+    REQUIRE_EQUAL(doc.text, "hello, world");
 
-    edit_text(text, range(0, 5, 0, 7), "");
-    REQUIRE_EQUAL(text, "helloworld");
+    edit_text(doc, range(0, 5, 0, 7), "");
+    REQUIRE_EQUAL(doc.text, "helloworld");
+
+    // section: line starts
+    {
+        edit_text(doc, range(0, 5, 0, 5), "\n\n");
+        REQUIRE_EQUAL(doc.text, "hello\n\nworld");
+        REQUIRE_EQUAL(doc.line_starts, line_starts(doc.text));
+
+        edit_text(doc, range(1, 0, 2, 2), "a\nb");
+        REQUIRE_EQUAL(doc.text, "hello\na\nbrld");
+        REQUIRE_EQUAL(doc.line_starts, line_starts(doc.text));
+
+        edit_text(doc, range(0, 2, 2, 1), "");
+        REQUIRE_EQUAL(doc.text, "herld");
+        REQUIRE_EQUAL(doc.line_starts, line_starts(doc.text));
+    }
+}
+
+UNITTEST("ki::db::text_offset")
+{
+    std::string_view const text   = "abc\ndefg\r\nhij";
+    auto const             starts = line_starts(text);
+
+    CHECK_EQUAL(text_offset(text, starts, Position { 0, 3 }), 3U);
+    CHECK_EQUAL(text_offset(text, starts, Position { 1, 4 }), 8U);
+    CHECK_EQUAL(text_offset(text, starts, Position { 2, 3 }), 13U);
+
+    // Columns past the end of a line are clamped to the end of the line.
+    CHECK_EQUAL(text_offset(text, starts, Position { 0, 4 }), 3U);
+    CHECK_EQUAL(text_offset(text, starts, Position { 0, 100 }), 3U);
+    CHECK_EQUAL(text_offset(text, starts, Position { 1, 5 }), 8U);
+    CHECK_EQUAL(text_offset(text, starts, Position { 2, 100 }), 13U);
+
+    // section: stale edit position
+    {
+        auto doc = document("ab\ncd", Ownership::Client);
+        edit_text(doc, range(0, 5, 0, 7), "x");
+        REQUIRE_EQUAL(doc.text, "abx\ncd");
+        REQUIRE_EQUAL(doc.line_starts, line_starts(doc.text));
+
+        edit_text(doc, range(0, 9, 1, 1), "");
+        REQUIRE_EQUAL(doc.text, "abxd");
+        REQUIRE_EQUAL(doc.line_starts, line_starts(doc.text));
+    }
+}
+
+UNITTEST("ki::db::merge_edit")
+{
+    auto doc = document("ab\ncd\nef", Ownership::Client);
+    REQUIRE(not doc.pending_edit.has_value());
+
+    edit_text(doc, range(1, 0, 1, 2), "xyz\nw");
+    REQUIRE_EQUAL(doc.text, "ab\nxyz\nw\nef");
+    REQUIRE(doc.pending_edit.has_value());
+    CHECK_EQUAL(doc.pending_edit.value().offset, 3U);
+    CHECK_EQUAL(doc.pending_edit.value().old_length, 2U);
+    CHECK_EQUAL(doc.pending_edit.value().new_length, 5U);
+    CHECK_EQUAL(doc.pending_edit.value().start_line, 1U);
+    CHECK_EQUAL(doc.pending_edit.value().old_stop_line, 1U);
+    CHECK_EQUAL(doc.pending_edit.value().new_stop_line, 2U);
+
+    // The merged region is "b\ncd" in the original text and "\nxyz\nw" in the current text.
+    edit_text(doc, range(0, 1, 0, 2), "");
+    REQUIRE_EQUAL(doc.text, "a\nxyz\nw\nef");
+    REQUIRE(doc.pending_edit.has_value());
+    CHECK_EQUAL(doc.pending_edit.value().offset, 1U);
+    CHECK_EQUAL(doc.pending_edit.value().old_length, 4U);
+    CHECK_EQUAL(doc.pending_edit.value().new_length, 6U);
+    CHECK_EQUAL(doc.pending_edit.value().start_line, 0U);
+    CHECK_EQUAL(doc.pending_edit.value().old_stop_line, 1U);
+    CHECK_EQUAL(doc.pending_edit.value().new_stop_line, 2U);
+
+    set_text(doc, "hello");
+    REQUIRE(doc.pending_edit.has_value());
+    CHECK_EQUAL(doc.pending_edit.value().offset, 0U);
+    CHECK_EQUAL(doc.pending_edit.value().old_length, 8U);
+    CHECK_EQUAL(doc.pending_edit.value().new_length, 5U);
+    CHECK_EQUAL(doc.pending_edit.value().old_stop_line, 2U);
+    CHECK_EQUAL(doc.pending_edit.value().new_stop_line, 0U);
+}
+
+UNITTEST("ki::db::line_starts")
+{
+    REQUIRE_EQUAL(line_starts(""), std::vector<std::uint32_t> { 0 });
+    REQUIRE_EQUAL(line_starts("abc\ndefg\n\nhij"), (std::vector<std::uint32_t> { 0, 4, 9, 10 }));
+}
+
+UNITTEST("ki::db::text_position")
+{
+    std::string_view const text   = "abc\ndefg\nhij";
+    auto const             starts = line_starts(text);
+
+    for (std::uint32_t offset = 0; offset != 13; ++offset) {
+        REQUIRE_EQUAL(text_offset(text, starts, text_position(starts, offset)), offset);
+    }
+    REQUIRE_EQUAL(text_position(starts, 0), Position { 0, 0 });
+    REQUIRE_EQUAL(text_position(starts, 3), Position { 0, 3 });
+    REQUIRE_EQUAL(text_position(starts, 4), Position { 1, 0 });
+    REQUIRE_EQUAL(text_position(starts, 12), Position { 2, 3 });
 }
 
 UNITTEST("ki::db::advance")
@@ -58,3 +156,60 @@ UNITTEST("ki::db::advance")
     position = advance(position, '\n');
     REQUIRE_EQUAL(position, Position { 1, 0 });
 }
+
+UNITTEST("ki::db::find_reference")
+{
+    auto const reference = [](Range range, std::size_t symbol) {
+        return Symbol_reference { .reference = { .range = range }, .symbol_id = Symbol_id(symbol) };
+    };
+
+    std::vector references {
+        reference(range(2, 4, 2, 7), 0),
+        reference(range(0, 0, 0, 3), 1),
+        reference(range(1, 2, 1, 5), 2),
+        reference(range(0, 5, 0, 6), 3),
+        reference(range(1, 2, 1, 5), 4),
+    };
+    sort_references(references);
+
+    auto const find = [&](std::uint32_t line, std::uint32_t column) -> std::optional<std::size_t> {
+        return find_reference(references, Position { line, column }).transform([](auto ref) {
+            return ref.symbol_id.get();
+        });
+    };
+
+    CHECK(find(0, 0) == 1UZ);
+    CHECK(find(0, 2) == 1UZ);
+    CHECK(find(0, 3) == std::nullopt);
+    CHECK(find(0, 5) == 3UZ);
+    CHECK(find(1, 0) == std::nullopt);
+    CHECK(find(1, 4) == 2UZ);
+    CHECK(find(2, 6) == 0UZ);
+    CHECK(find(2, 7) == std::nullopt);
+    CHECK(find(3, 0) == std::nullopt);
+}
+
+UNITTEST("ki::db::index_references")
+{
+    auto const reference = [](std::uint32_t line, std::size_t symbol) {
+        return Symbol_reference {
+            .reference = { .range = range(line, 0, line, 1) },
+            .symbol_id = Symbol_id(symbol),
+        };
+    };
+
+    Document_info info;
+    info.references = { reference(3, 2), reference(0, 0), reference(2, 2), reference(1, 0) };
+    index_references(info);
+
+    auto const lines = [&](std::size_t symbol) {
+        return symbol_references(info.reference_postings, Symbol_id(symbol))
+             | std::views::transform([](Reference ref) { return ref.range.start.line; })
+             | std::ranges::to<std::vector>();
+    };
+
+    CHECK((lines(0) == std::vector<std::uint32_t> { 0, 1 }));
+    CHECK(lines(1).empty());
+    CHECK((lines(2) == std::vector<std::uint32_t> { 2, 3 }));
+    CHECK(lines(3).empty());
+}
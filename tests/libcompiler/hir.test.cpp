@@ -0,0 +1,37 @@
+#include <libutl/utilities.hpp>
+#include <cppunittest/unittest.hpp>
+#include <libcompiler/hir/hir.hpp>
+
+using namespace ki;
+
+UNITTEST("ki::hir::intern_type")
+{
+    hir::Arena arena;
+
+    auto const i32 = hir::intern_type(arena, hir::type::Builtin::I32);
+    auto const u8  = hir::intern_type(arena, hir::type::Builtin::U8);
+
+    CHECK(hir::intern_type(arena, hir::type::Builtin::I32) == i32);
+    CHECK(i32 != u8);
+
+    auto const function = [&](std::initializer_list<hir::Type_id> parameters, hir::Type_id result) {
+        return hir::intern_type(
+            arena,
+            hir::type::Function {
+                .parameter_types = std::pmr::vector<hir::Type_id>(parameters),
+                .return_type     = result,
+            });
+    };
+
+    auto const binary = function({ i32, i32 }, i32);
+    CHECK(function({ i32, i32 }, i32) == binary);
+    CHECK(function({ i32 }, i32) != binary);
+    CHECK(function({ i32, i32 }, u8) != binary);
+
+    auto const pair = hir::intern_type(arena, hir::type::Tuple { { i32, u8 } });
+    CHECK(hir::intern_type(arena, hir::type::Tuple { { i32, u8 } }) == pair);
+    CHECK(hir::intern_type(arena, hir::type::Tuple { { u8, i32 } }) != pair);
+    CHECK(hir::intern_type(arena, hir::type::Tuple {}) != pair);
+
+    CHECK_EQUAL(arena.types.size(), 8UZ);
+}
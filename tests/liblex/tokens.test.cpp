@@ -1,4 +1,5 @@
 #include <libutl/utilities.hpp>
+#include <libcompiler/db.hpp>
 #include <liblex/lex.hpp>
 #include <cppunittest/unittest.hpp>
 
@@ -7,7 +8,8 @@ using namespace ki;
 namespace {
     auto tokens(std::string_view const document) -> std::string
     {
-        auto state  = lex::state(document);
+        auto starts = db::line_starts(document);
+        auto state  = lex::state(document, starts);
         auto output = std::string {};
 
         for (;;) {
@@ -86,3 +88,58 @@ UNITTEST("available operators")
     REQUIRE_EQUAL(
         tokens("-- %?% <$> ** @#"), R"((op: "--")(op: "%?%")(op: "<$>")(op: "**")(op: "@#"))");
 }
+
+UNITTEST("token positions")
+{
+    std::string_view const document = "a /* x\n y */ b\n\n  \"c\"";
+
+    auto const starts = db::line_starts(document);
+    auto       state  = lex::state(document, starts);
+
+    REQUIRE_EQUAL(lex::next(state).range, lsp::Range({ 0, 0 }, { 0, 1 }));
+    REQUIRE_EQUAL(lex::next(state).range, lsp::Range({ 1, 6 }, { 1, 7 }));
+    REQUIRE_EQUAL(lex::next(state).range, lsp::Range({ 3, 2 }, { 3, 5 }));
+    REQUIRE_EQUAL(lex::next(state).range, lsp::to_range(lsp::Position { 3, 5 }));
+
+    lex::seek(state, 13);
+    REQUIRE_EQUAL(lex::position(state), lsp::Position { 1, 6 });
+    REQUIRE_EQUAL(lex::next(state).view.string(document), "b");
+}
+
+UNITTEST("long runs")
+{
+    auto const name    = std::string(40, 'x') + "_Y'9";
+    auto const spaces  = std::string(37, ' ') + "\n\t\r";
+    auto const comment = "/* " + std::string(50, '-') + " /* * / */ */";
+
+    REQUIRE_EQUAL(
+        tokens(name + spaces + name), std::format(R"((lower: "{0}")(lower: "{0}"))", name));
+    REQUIRE_EQUAL(tokens(comment + spaces + "a" + comment), R"((lower: "a"))");
+    REQUIRE_EQUAL(tokens("// " + std::string(40, '/') + "\nb"), R"((lower: "b"))");
+}
+
+UNITTEST("token buffer")
+{
+    std::string_view const document = "fn f() {\n    \"x\" /* y */ 1.5 }\n// z\n";
+
+    auto const starts = db::line_starts(document);
+    auto       state  = lex::state(document, starts);
+    auto       buffer = lex::state(document, starts);
+    auto const tokens = lex::lex_all(buffer);
+
+    REQUIRE_EQUAL(tokens.types.size(), 9UZ);
+    REQUIRE_EQUAL(tokens.offsets.size(), tokens.types.size());
+    REQUIRE_EQUAL(tokens.lengths.size(), tokens.types.size());
+    REQUIRE_EQUAL(tokens.lines.size(), tokens.types.size());
+    REQUIRE_EQUAL(lex::position(buffer), lsp::Position { 3, 0 });
+
+    for (std::size_t index = 0; index != tokens.types.size(); ++index) {
+        auto const expected = lex::next(state);
+        auto const actual   = lex::token(tokens, index);
+        REQUIRE(expected.type == actual.type);
+        REQUIRE_EQUAL(expected.range, actual.range);
+        REQUIRE_EQUAL(expected.view.offset, actual.view.offset);
+        REQUIRE_EQUAL(expected.view.length, actual.view.length);
+    }
+    REQUIRE(tokens.types.back() == lex::Type::End_of_input);
+}
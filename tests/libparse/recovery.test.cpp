@@ -0,0 +1,66 @@
+#include <libutl/utilities.hpp>
+#include <libparse/parse.hpp>
+#include <cppunittest/unittest.hpp>
+#include "test_interface.hpp"
+
+static constexpr auto parse = ki::par::test_parse_document;
+
+#define TEST(name) UNITTEST("parse recovery: " name)
+
+TEST("well-formed definitions")
+{
+    auto const result = parse("fn f() {} struct S { s: I32 } alias A = S");
+    CHECK_EQUAL(result.definition_count, 3UZ);
+    CHECK(result.diagnostics.empty());
+}
+
+TEST("only the first error in a definition is reported")
+{
+    auto const result = parse("fn f( {} fn g() = 5 fn h() = ) fn i() {}");
+    CHECK_EQUAL(result.definition_count, 2UZ);
+    REQUIRE_EQUAL(result.diagnostics.size(), 2UZ);
+}
+
+TEST("unexpected token between definitions")
+{
+    auto const result = parse("fn f() {} 5 fn g() {}");
+    CHECK_EQUAL(result.definition_count, 2UZ);
+    CHECK_EQUAL(result.diagnostics.size(), 1UZ);
+}
+
+TEST("no semantic tokens after the first error in a definition")
+{
+    std::string_view const text   = "fn f( {} fn g() = 5";
+    auto const             result = parse(std::string(text));
+    CHECK_EQUAL(result.definition_count, 1UZ);
+    REQUIRE_EQUAL(result.diagnostics.size(), 1UZ);
+
+    // The placeholders that finish `f` have no tokens of their own, so they would be highlighted
+    // over the whitespace that follows the last real token.
+    for (ki::lsp::Semantic_token const& token : result.semantic_tokens) {
+        CHECK(not text.substr(token.position.column, token.length).contains(' '));
+    }
+
+    // The tokens of `g` are kept.
+    CHECK(std::ranges::contains(
+        result.semantic_tokens, 9U, [](ki::lsp::Semantic_token const& token) {
+            return token.position.column;
+        }));
+}
+
+UNITTEST("ki::par::peek lookahead")
+{
+    auto db  = ki::db::Database {};
+    auto ctx = ki::par::context(db, ki::db::test_document(db, "fn f\n()"), ki::db::ignore_sink);
+    ki::par::prelex(ctx);
+
+    CHECK(ki::par::peek(ctx, 2).type == ki::lex::Type::Paren_open);
+    CHECK_EQUAL(ki::par::peek(ctx, 2).range, ki::lsp::Range({ 1, 0 }, { 1, 1 }));
+    CHECK(ki::par::peek(ctx, 4).type == ki::lex::Type::End_of_input);
+    CHECK(ki::par::peek(ctx, 100).type == ki::lex::Type::End_of_input);
+
+    // Lookahead does not consume anything.
+    CHECK(ki::par::extract(ctx).type == ki::lex::Type::Fn);
+    CHECK(ki::par::peek(ctx, 0).type == ki::lex::Type::Lower_name);
+    CHECK(ki::par::peek(ctx, 1).type == ki::lex::Type::Paren_open);
+}
@@ -15,13 +15,33 @@ namespace {
         auto par_ctx = context(db, doc_id, db::ignore_sink);
         auto result  = require<parser>(par_ctx, expectation);
 
-        if (is_finished(par_ctx)) {
-            return fmt::to_string(db, par_ctx.arena, result);
+        if (not is_finished(par_ctx)) {
+            error_expected(par_ctx, expectation);
         }
-        error_expected(par_ctx, expectation);
+        if (par_ctx.has_error) {
+            throw std::runtime_error(std::format("Failed to parse {}", expectation));
+        }
+        return fmt::to_string(db, par_ctx.arena, result);
     }
 } // namespace
 
+auto ki::par::test_parse_document(std::string text) -> Document_parse_result
+{
+    auto result = Document_parse_result {};
+    auto sink   = [&](lsp::Diagnostic diagnostic) {
+        result.diagnostics.push_back(std::move(diagnostic.message));
+    };
+    auto db = db::Database {};
+
+    db.config.semantic_tokens = db::Semantic_token_mode::Full;
+
+    auto doc_id  = db::test_document(db, std::move(text));
+    auto par_ctx = context(db, doc_id, sink);
+    parse(par_ctx, [&](auto const&) { ++result.definition_count; });
+    result.semantic_tokens = std::move(par_ctx.semantic_tokens);
+    return result;
+}
+
 auto ki::par::test_parse_expression(std::string text) -> std::string
 {
     return test_parse<parse_expression>(std::move(text), "an expression");
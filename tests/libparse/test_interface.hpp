@@ -2,6 +2,7 @@
 #define KIELI_LIBPARSE_TEST_INTERFACE
 
 #include <libutl/utilities.hpp>
+#include <libcompiler/lsp.hpp>
 
 namespace ki::par {
 
@@ -9,6 +10,16 @@ namespace ki::par {
     auto test_parse_pattern(std::string text) -> std::string;
     auto test_parse_type(std::string text) -> std::string;
 
+    struct Document_parse_result {
+        std::size_t                      definition_count {};
+        std::vector<std::string>         diagnostics;
+        std::vector<lsp::Semantic_token> semantic_tokens;
+    };
+
+    // Parse every definition in `text`, collecting the emitted diagnostic messages and semantic
+    // tokens.
+    auto test_parse_document(std::string text) -> Document_parse_result;
+
 } // namespace ki::par
 
 #endif // KIELI_LIBPARSE_TEST_INTERFACE
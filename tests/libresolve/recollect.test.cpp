@@ -0,0 +1,216 @@
+#include <libutl/utilities.hpp>
+#include <libresolve/resolve.hpp>
+#include <cppunittest/unittest.hpp>
+
+using namespace ki;
+
+namespace {
+    constexpr std::string_view three_functions
+        = "fn f(): I32 = 1\n"
+          "fn g(): I32 = f()\n"
+          "fn h(): I32 = 3\n";
+
+    auto range(std::uint32_t a, std::uint32_t b, std::uint32_t c, std::uint32_t d) -> lsp::Range
+    {
+        return lsp::Range({ .line = a, .column = b }, { .line = c, .column = d });
+    }
+
+    auto collect(
+        db::Database& db, db::Document_id doc_id, db::Diagnostic_sink sink = db::ignore_sink)
+        -> res::Context
+    {
+        auto ctx = res::context(doc_id, sink);
+        db.documents[doc_id].info.root_env_id = ctx.root_env_id;
+        res::collect_document(db, ctx);
+        return ctx;
+    }
+
+    void resolve(db::Database& db, res::Context& ctx)
+    {
+        for (res::Definition const& definition : ctx.definitions) {
+            if (definition.symbol_id.has_value()) {
+                res::resolve_symbol(db, ctx, definition.symbol_id.value());
+            }
+        }
+    }
+
+    // Replace `range` in the text of the document and bring `ctx` up to date.
+    auto edit(db::Database& db, res::Context& ctx, lsp::Range range, std::string_view text)
+        -> bool
+    {
+        auto& doc = db.documents[ctx.doc_id];
+        db::edit_text(doc, range, text);
+        return res::recollect_edit(db, ctx, std::exchange(doc.pending_edit, std::nullopt).value());
+    }
+
+    // Count the diagnostics, semantic tokens, and references that start on `line`.
+    auto count_on_line(db::Document_info const& info, std::uint32_t const line)
+        -> std::tuple<std::ptrdiff_t, std::ptrdiff_t, std::ptrdiff_t>
+    {
+        return {
+            std::ranges::count(info.diagnostics, line, [](lsp::Diagnostic const& diagnostic) {
+                return diagnostic.range.start.line;
+            }),
+            std::ranges::count(info.semantic_tokens, line, [](lsp::Semantic_token const& token) {
+                return token.position.line;
+            }),
+            std::ranges::count(info.references, line, [](db::Symbol_reference const& reference) {
+                return reference.reference.range.start.line;
+            }),
+        };
+    }
+
+    auto function(res::Context& ctx, std::size_t index) -> hir::Function_info&
+    {
+        auto const symbol_id = ctx.definitions.at(index).symbol_id.value();
+        return ctx.arena.hir.functions[std::get<hir::Function_id>(
+            ctx.arena.symbols[symbol_id].variant)];
+    }
+} // namespace
+
+UNITTEST("ki::res::recollect_edit after cancellation")
+{
+    auto db  = db::Database {};
+    auto ctx = collect(db, db::test_document(db, "fn f(): I32 = 1\nfn g(): I32 = 2\n"));
+    REQUIRE_EQUAL(ctx.definitions.size(), 2UZ);
+
+    // Cancellation is observed before the second symbol is resolved.
+    db.cancellation = db::cancellation_token();
+    res::resolve_symbol(db, ctx, ctx.definitions.at(0).symbol_id.value());
+    db::cancel(db.cancellation);
+    REQUIRE_THROWS_AS(
+        db::Job_cancelled, res::resolve_symbol(db, ctx, ctx.definitions.at(1).symbol_id.value()));
+
+    CHECK(ctx.active_queries.empty());
+    REQUIRE(function(ctx, 0).body_id.has_value());
+    REQUIRE(not function(ctx, 1).body_id.has_value());
+    auto const body_id = function(ctx, 0).body_id.value();
+
+    // The context can still be brought up to date, even though the token remains cancelled.
+    REQUIRE(edit(db, ctx, range(1, 14, 1, 15), "3"));
+    CHECK(db::is_cancelled(db.cancellation));
+
+    // Resolution resumes where it stopped.
+    db.cancellation = db::Cancellation_token {};
+    resolve(db, ctx);
+    CHECK(function(ctx, 0).body_id == body_id);
+    CHECK(function(ctx, 1).body_id.has_value());
+}
+
+UNITTEST("ki::res::recollect_edit body edit")
+{
+    auto db  = db::Database {};
+    auto ctx = collect(db, db::test_document(db, std::string(three_functions)));
+    REQUIRE_EQUAL(ctx.definitions.size(), 3UZ);
+    resolve(db, ctx);
+
+    auto const symbols   = ctx.arena.symbols.size();
+    auto const functions = ctx.arena.hir.functions.size();
+    auto const symbol_id = ctx.definitions.at(1).symbol_id.value();
+    auto const g_id      = std::get<hir::Function_id>(ctx.arena.symbols[symbol_id].variant);
+    auto const f_body_id = function(ctx, 0).body_id.value();
+    auto const g_body_id = function(ctx, 1).body_id.value();
+    auto const h_body_id = function(ctx, 2).body_id.value();
+
+    REQUIRE(edit(db, ctx, range(2, 14, 2, 15), "4"));
+
+    // Only the edited definition is invalidated, and no symbols or functions are created.
+    CHECK_EQUAL(ctx.arena.symbols.size(), symbols);
+    CHECK_EQUAL(ctx.arena.hir.functions.size(), functions);
+    CHECK(ctx.definitions.at(1).symbol_id == symbol_id);
+    CHECK(std::get<hir::Function_id>(ctx.arena.symbols[symbol_id].variant) == g_id);
+    CHECK(function(ctx, 0).body_id == f_body_id);
+    CHECK(function(ctx, 1).body_id == g_body_id);
+    CHECK(not function(ctx, 2).body_id.has_value());
+    CHECK(not function(ctx, 2).signature.has_value());
+
+    resolve(db, ctx);
+    CHECK(function(ctx, 0).body_id == f_body_id);
+    CHECK(function(ctx, 1).body_id == g_body_id);
+    REQUIRE(function(ctx, 2).body_id.has_value());
+    CHECK(function(ctx, 2).body_id != h_body_id);
+}
+
+UNITTEST("ki::res::recollect_edit signature edit")
+{
+    auto db  = db::Database {};
+    auto ctx = collect(db, db::test_document(db, std::string(three_functions)));
+    REQUIRE_EQUAL(ctx.definitions.size(), 3UZ);
+    resolve(db, ctx);
+
+    auto const h_body_id = function(ctx, 2).body_id.value();
+
+    // The body of `g` calls `f`, so it depends on the signature of `f`.
+    REQUIRE(edit(db, ctx, range(0, 8, 0, 11), "I64"));
+    CHECK(not function(ctx, 0).signature.has_value());
+    CHECK(not function(ctx, 0).body_id.has_value());
+    CHECK(not function(ctx, 1).body_id.has_value());
+    CHECK(function(ctx, 2).body_id == h_body_id);
+
+    resolve(db, ctx);
+    CHECK(function(ctx, 0).signature.has_value());
+    CHECK(function(ctx, 1).body_id.has_value());
+    CHECK(function(ctx, 2).body_id == h_body_id);
+}
+
+UNITTEST("ki::res::is_retainable")
+{
+    auto db  = db::Database {};
+    auto ctx = collect(db, db::test_document(db, std::string(three_functions)));
+
+    auto const baseline_size = ctx.arena.ast.expressions.size();
+    REQUIRE(res::is_retainable(ctx.arena, baseline_size));
+
+    // Every edit leaves the replaced body of `f` behind in the arena.
+    std::size_t edit_count = 0;
+    while (res::is_retainable(ctx.arena, baseline_size) and edit_count != 100) {
+        REQUIRE(edit(db, ctx, range(0, 14, 0, 15), "1"));
+        ++edit_count;
+    }
+    CHECK(edit_count > 1);
+    CHECK(not res::is_retainable(ctx.arena, baseline_size));
+    CHECK(ctx.arena.ast.expressions.size() > 2 * baseline_size);
+}
+
+UNITTEST("ki::res::recollect_edit line insertion")
+{
+    auto db = db::Database {};
+
+    db.config.semantic_tokens = db::Semantic_token_mode::Full;
+    db.config.references      = true;
+
+    auto const doc_id = db::test_document(
+        db,
+        "fn f(): I32 = 1\n"
+        "fn g(): I32 = f()\n"
+        "fn h(): I32 = x\n");
+
+    auto sink = [&](lsp::Diagnostic diagnostic) {
+        db.documents[doc_id].info.diagnostics.push_back(std::move(diagnostic));
+    };
+    auto ctx = collect(db, doc_id, sink);
+    resolve(db, ctx);
+
+    auto const& info   = db.documents[doc_id].info;
+    auto const  counts = count_on_line(info, 2);
+    REQUIRE(std::get<0>(counts) != 0);
+    REQUIRE(std::get<1>(counts) != 0);
+    REQUIRE(std::get<2>(counts) != 0);
+
+    auto const view     = ctx.definitions.at(2).view;
+    auto const ast_body = function(ctx, 2).ast.body;
+    auto const body_id  = function(ctx, 2).body_id.value();
+
+    // Insert two lines before `g`. The definition of `h` is shifted without being parsed again.
+    REQUIRE(edit(db, ctx, range(1, 0, 1, 0), "\n\n"));
+
+    CHECK(count_on_line(info, 2) == std::tuple<std::ptrdiff_t, std::ptrdiff_t, std::ptrdiff_t> {});
+    CHECK(count_on_line(info, 4) == counts);
+
+    CHECK_EQUAL(ctx.definitions.at(2).view.offset, view.offset + 2);
+    CHECK_EQUAL(ctx.definitions.at(2).view.length, view.length);
+    CHECK_EQUAL(ctx.definitions.at(2).range.start.line, 4U);
+    CHECK_EQUAL(function(ctx, 2).name.range.start.line, 4U);
+    CHECK(function(ctx, 2).ast.body == ast_body);
+    CHECK(function(ctx, 2).body_id == body_id);
+}
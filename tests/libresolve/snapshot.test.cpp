@@ -0,0 +1,180 @@
+#include <libutl/utilities.hpp>
+#include <libresolve/resolve.hpp>
+#include <cppunittest/unittest.hpp>
+
+using namespace ki;
+
+namespace {
+    auto variable_id(res::Context const& ctx, hir::Type_id const type_id) -> hir::Type_variable_id
+    {
+        return std::get<hir::type::Variable>(ctx.arena.hir.types[type_id]).id;
+    }
+
+    // Check that the arena slot of `type_id` still holds its own unsolved variable.
+    auto is_unsolved(res::Context const& ctx, res::Block_state const& state, hir::Type_id type_id)
+        -> bool
+    {
+        auto const* variable = std::get_if<hir::type::Variable>(&ctx.arena.hir.types[type_id]);
+        return variable != nullptr and not state.type_vars.at(variable->id.get()).is_solved;
+    }
+
+    auto is_solved(res::Block_state& state, hir::Type_variable_id const var_id) -> bool
+    {
+        return state.type_vars.at(state.type_var_set.find(var_id).get()).is_solved;
+    }
+
+    // Resolve every definition in `text`, and return the emitted diagnostic messages.
+    auto resolve_diagnostics(std::string text) -> std::vector<std::string>
+    {
+        auto diagnostics = std::vector<std::string> {};
+        auto sink        = [&](lsp::Diagnostic diagnostic) {
+            diagnostics.push_back(std::move(diagnostic.message));
+        };
+
+        auto db  = db::Database {};
+        auto ctx = res::context(db::test_document(db, std::move(text)), sink);
+
+        db.documents[ctx.doc_id].info.root_env_id = ctx.root_env_id;
+        for (db::Symbol_id symbol_id : res::collect_document(db, ctx)) {
+            res::resolve_symbol(db, ctx, symbol_id);
+        }
+        return diagnostics;
+    }
+} // namespace
+
+UNITTEST("ki::res::rollback")
+{
+    auto       db    = db::Database {};
+    auto       ctx   = res::context(db::test_document(db, ""), db::ignore_sink);
+    auto       state = res::Block_state {};
+    auto const range = lsp::Range {};
+
+    auto const a   = res::fresh_general_type_variable(ctx, state, range);
+    auto const b   = res::fresh_general_type_variable(ctx, state, range);
+    auto const mut = res::fresh_mutability_variable(ctx, state, range);
+
+    auto const a_var = variable_id(ctx, a);
+    auto const b_var = variable_id(ctx, b);
+
+    state.loop_info
+        = res::Loop_info { .result_type_id = std::nullopt, .source = ast::Loop_source::While_loop };
+
+    auto const snapshot = res::snapshot(state);
+    state.loop_info.reset();
+
+    auto const c = res::fresh_integral_type_variable(ctx, state, range);
+    res::require_subtype_relationship(
+        db, ctx, state, range, ctx.arena.hir.types[a], ctx.arena.hir.types[b]);
+    res::require_subtype_relationship(
+        db, ctx, state, range, ctx.arena.hir.types[b], ctx.arena.hir.types[c]);
+    res::require_subtype_relationship(
+        db, ctx, state, range, ctx.arena.hir.types[c], hir::type::Builtin::I64);
+    res::require_submutability_relationship(
+        db, ctx, state, range, ctx.arena.hir.mutabilities[mut.id], db::Mutability::Mut);
+
+    REQUIRE(is_solved(state, a_var));
+    REQUIRE(state.mut_vars.at(0).is_solved);
+    REQUIRE(not state.undo_log.empty());
+
+    res::rollback(ctx, state, snapshot);
+
+    CHECK_EQUAL(state.type_vars.size(), 2UZ);
+    CHECK(is_unsolved(ctx, state, a));
+    CHECK(is_unsolved(ctx, state, b));
+    CHECK(state.type_vars.at(b_var.get()).kind == hir::Type_variable_kind::General);
+    CHECK(state.type_var_set.find(a_var) != state.type_var_set.find(b_var));
+
+    CHECK(std::holds_alternative<hir::mut::Variable>(ctx.arena.hir.mutabilities[mut.id]));
+    CHECK(not state.mut_vars.at(0).is_solved);
+
+    REQUIRE(state.loop_info.has_value());
+    CHECK(state.loop_info.value().source == ast::Loop_source::While_loop);
+    CHECK(state.undo_log.empty());
+    CHECK_EQUAL(state.open_snapshots, 0UZ);
+}
+
+UNITTEST("ki::res::commit")
+{
+    auto       db    = db::Database {};
+    auto       ctx   = res::context(db::test_document(db, ""), db::ignore_sink);
+    auto       state = res::Block_state {};
+    auto const range = lsp::Range {};
+
+    auto const a = res::fresh_general_type_variable(ctx, state, range);
+    auto const b = res::fresh_general_type_variable(ctx, state, range);
+
+    auto const a_var = variable_id(ctx, a);
+    auto const b_var = variable_id(ctx, b);
+
+    auto const outer = res::snapshot(state);
+    auto const inner = res::snapshot(state);
+    res::require_subtype_relationship(
+        db, ctx, state, range, ctx.arena.hir.types[a], hir::type::Builtin::I32);
+    res::commit(state, inner);
+
+    // Changes committed to an inner snapshot are still undone by the outer one.
+    CHECK(is_solved(state, a_var));
+    CHECK_EQUAL(state.open_snapshots, 1UZ);
+    res::rollback(ctx, state, outer);
+    CHECK(is_unsolved(ctx, state, a));
+
+    auto const snapshot = res::snapshot(state);
+    res::require_subtype_relationship(
+        db, ctx, state, range, ctx.arena.hir.types[b], hir::type::Builtin::Bool);
+    res::commit(state, snapshot);
+
+    CHECK(is_solved(state, b_var));
+    CHECK(state.undo_log.empty());
+    CHECK_EQUAL(state.open_snapshots, 0UZ);
+}
+
+UNITTEST("ki::res::try_subtype_relationship")
+{
+    auto diagnostics = std::vector<lsp::Diagnostic> {};
+    auto sink        = [&](lsp::Diagnostic diagnostic) { diagnostics.push_back(diagnostic); };
+
+    auto       db    = db::Database {};
+    auto       ctx   = res::context(db::test_document(db, ""), sink);
+    auto       state = res::Block_state {};
+    auto const range = lsp::Range {};
+
+    auto const a       = res::fresh_general_type_variable(ctx, state, range);
+    auto const a_var   = variable_id(ctx, a);
+    auto const i32     = ctx.builtins.type_i32;
+    auto const u8      = ctx.builtins.type_u8;
+    auto const boolean = ctx.builtins.type_bool;
+
+    // The first element unifies, so `a` is solved before the second element fails.
+    auto const sub = hir::Type_variant { hir::type::Tuple { .types = { a, i32 } } };
+    CHECK(not res::try_subtype_relationship(
+        db, ctx, state, sub, hir::type::Tuple { .types = { u8, boolean } }));
+    CHECK(is_unsolved(ctx, state, a));
+    CHECK(diagnostics.empty());
+
+    CHECK(res::try_subtype_relationship(
+        db, ctx, state, sub, hir::type::Tuple { .types = { u8, i32 } }));
+    CHECK(is_solved(state, a_var));
+    CHECK(diagnostics.empty());
+    CHECK_EQUAL(state.open_snapshots, 0UZ);
+}
+
+UNITTEST("ki::res conditional branch types")
+{
+    // section: branches of the same type
+    {
+        CHECK(resolve_diagnostics("fn f(): I32 = if true { 5 } else { 6 }").empty());
+    }
+    // section: the true branch diverges, so the type of the false branch is used
+    {
+        CHECK(resolve_diagnostics("fn f(): I32 = if true { ret 5 } else { 6 }").empty());
+    }
+    // section: the false branch diverges
+    {
+        CHECK(resolve_diagnostics("fn f(): I32 = if true { 5 } else { ret 6 }").empty());
+    }
+    // section: neither branch is a subtype of the other
+    {
+        auto const diagnostics = resolve_diagnostics("fn f(): I32 = if true { 5 } else { false }");
+        CHECK_EQUAL(diagnostics.size(), 1UZ);
+    }
+}
@@ -5,8 +5,16 @@
 using namespace ki;
 
 namespace {
-    auto in_same_set(utl::Disjoint_set& set, std::size_t const x, std::size_t const y) -> bool
+    struct Index : utl::Vector_index<Index> {
+        using Vector_index::Vector_index;
+    };
+
+    using Set = utl::Disjoint_set<Index>;
+
+    auto in_same_set(Set& set, std::size_t const x_value, std::size_t const y_value) -> bool
     {
+        Index const x(x_value);
+        Index const y(y_value);
         bool const equal = set.find_without_compressing(x) == set.find_without_compressing(y);
         REQUIRE_EQUAL(equal, set.find_without_compressing(y) == set.find_without_compressing(x));
         REQUIRE_EQUAL(equal, set.find(x) == set.find(y));
@@ -14,8 +22,9 @@ namespace {
         return equal;
     }
 
-    auto has_no_parent(utl::Disjoint_set& set, std::size_t const x) -> bool
+    auto has_no_parent(Set& set, std::size_t const x_value) -> bool
     {
+        Index const x(x_value);
         bool const equal = x == set.find_without_compressing(x);
         REQUIRE_EQUAL(equal, x == set.find(x));
         return equal;
@@ -24,15 +33,15 @@ namespace {
 
 UNITTEST("libutl disjoint_set")
 {
-    utl::Disjoint_set set { 10 };
+    Set set { 10 };
 
     for (std::size_t i = 0; i != 10; ++i) {
         CHECK(has_no_parent(set, i));
     }
 
-    set.merge(0, 2);
-    set.merge(2, 4);
-    set.merge(7, 9);
+    set.merge(Index(0), Index(2));
+    set.merge(Index(2), Index(4));
+    set.merge(Index(7), Index(9));
 
     CHECK(in_same_set(set, 0, 2));
     CHECK(in_same_set(set, 2, 4));
@@ -45,5 +54,55 @@ UNITTEST("libutl disjoint_set")
     CHECK(has_no_parent(set, 6));
     CHECK(has_no_parent(set, 8));
 
-    CHECK_THROWS_AS(std::out_of_range, set.find(10));
+    CHECK_THROWS_AS(std::out_of_range, set.find(Index(10)));
+}
+
+UNITTEST("libutl disjoint_set rollback")
+{
+    Set set { 6 };
+    set.merge(Index(0), Index(1));
+
+    auto const outer = set.snapshot();
+    set.merge(Index(1), Index(2));
+
+    auto const inner = set.snapshot();
+    set.merge(Index(3), Index(4));
+    CHECK(set.add() == Index(6));
+    set.merge(Index(6), Index(0));
+    CHECK(in_same_set(set, 6, 2));
+    set.rollback(inner);
+
+    CHECK(in_same_set(set, 0, 2));
+    CHECK(not in_same_set(set, 3, 4));
+    CHECK_THROWS_AS(std::out_of_range, set.find(Index(6)));
+
+    auto const committed = set.snapshot();
+    set.merge(Index(4), Index(5));
+    set.commit(committed);
+    CHECK(in_same_set(set, 4, 5));
+
+    set.rollback(outer);
+
+    CHECK(in_same_set(set, 0, 1));
+    CHECK(not in_same_set(set, 1, 2));
+    CHECK(not in_same_set(set, 4, 5));
+    for (std::size_t i = 2; i != 6; ++i) {
+        CHECK(has_no_parent(set, i));
+    }
+}
+
+UNITTEST("libutl disjoint_set long chains")
+{
+    std::size_t const size = 100'000;
+
+    Set set { size };
+    for (std::size_t i = 1; i != size; ++i) {
+        set.merge(Index(i - 1), Index(i));
+    }
+
+    Index const root = set.find(Index(0));
+    for (std::size_t i = 0; i != size; ++i) {
+        REQUIRE(set.find_without_compressing(Index(i)) == root);
+    }
+    CHECK(set.find(Index(size - 1)) == root);
 }
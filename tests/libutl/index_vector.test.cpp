@@ -33,4 +33,12 @@ UNITTEST("libutl index_vector")
     CHECK_EQUAL(vector[a], "hello, world");
     CHECK_EQUAL(vector[b], "aaaaa");
     CHECK_EQUAL(vector[c], "third");
+
+    CHECK_EQUAL(vector.size(), 3UZ);
+    auto const expected = std::to_array<std::string>({ "hello, world", "aaaaa", "third" });
+    CHECK(std::ranges::equal(vector, expected));
+
+    if constexpr (utl::checked_indexing) {
+        CHECK_THROWS_AS(std::out_of_range, (void)vector[Index(3)]);
+    }
 }
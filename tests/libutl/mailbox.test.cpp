@@ -9,22 +9,82 @@ UNITTEST("mailbox")
     utl::Mailbox<std::string> mailbox;
 
     REQUIRE(mailbox.is_empty());
-    REQUIRE(mailbox.pop() == std::nullopt);
+    REQUIRE(mailbox.try_pop() == std::nullopt);
 
     mailbox.push(5, 'a');
 
     REQUIRE(not mailbox.is_empty());
-    REQUIRE(mailbox.pop() == "aaaaa");
-    REQUIRE(mailbox.pop() == std::nullopt);
+    REQUIRE(mailbox.try_pop() == "aaaaa");
+    REQUIRE(mailbox.try_pop() == std::nullopt);
 
     mailbox.push("aaa");
     mailbox.push("bbb");
     mailbox.push("ccc");
 
     REQUIRE(not mailbox.is_empty());
-    REQUIRE(mailbox.pop() == "aaa");
-    REQUIRE(mailbox.pop() == "bbb");
-    REQUIRE(mailbox.pop() == "ccc");
-    REQUIRE(mailbox.pop() == std::nullopt);
+    REQUIRE(mailbox.try_pop() == "aaa");
+    REQUIRE(mailbox.try_pop() == "bbb");
+    REQUIRE(mailbox.try_pop() == "ccc");
+    REQUIRE(mailbox.try_pop() == std::nullopt);
+    REQUIRE(mailbox.is_empty());
+}
+
+UNITTEST("mailbox wait_pop")
+{
+    utl::Mailbox<int> mailbox;
+
+    std::jthread producer([&] {
+        for (int i = 0; i != 100; ++i) {
+            mailbox.push(i);
+        }
+    });
+
+    for (int i = 0; i != 100; ++i) {
+        REQUIRE_EQUAL(mailbox.wait_pop(), i);
+    }
+    REQUIRE(mailbox.is_empty());
+}
+
+UNITTEST("mailbox drain")
+{
+    utl::Mailbox<int> mailbox;
+
+    mailbox.push(1);
+    mailbox.push(2);
+    REQUIRE_EQUAL(mailbox.try_pop(), 1);
+    mailbox.push(3);
+    mailbox.push(4);
+
+    std::vector<int> output { 0 };
+    mailbox.drain(output);
+    CHECK((output == std::vector { 0, 2, 3, 4 }));
+    CHECK(mailbox.is_empty());
+
+    mailbox.drain(output);
+    CHECK_EQUAL(output.size(), 4UZ);
+}
+
+UNITTEST("mailbox multiple producers")
+{
+    utl::Mailbox<int> mailbox;
+
+    constexpr int producer_count = 4;
+    constexpr int message_count  = 1000;
+
+    std::vector<std::jthread> producers;
+    for (int p = 0; p != producer_count; ++p) {
+        producers.emplace_back([&mailbox, p] {
+            for (int i = 0; i != message_count; ++i) {
+                mailbox.push((p * message_count) + i);
+            }
+        });
+    }
+
+    // Messages from each producer must arrive in the order they were pushed.
+    std::vector<int> next(producer_count);
+    for (int i = 0; i != producer_count * message_count; ++i) {
+        int const mail = mailbox.wait_pop();
+        REQUIRE_EQUAL(mail % message_count, next.at(mail / message_count)++);
+    }
     REQUIRE(mailbox.is_empty());
 }
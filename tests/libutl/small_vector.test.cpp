@@ -0,0 +1,69 @@
+#include <libutl/utilities.hpp>
+#include <libutl/small_vector.hpp>
+#include <cppunittest/unittest.hpp>
+
+using namespace ki;
+
+namespace {
+    using Vector = utl::Small_vector<std::string, 2>;
+
+    static_assert(std::ranges::contiguous_range<Vector>);
+    static_assert(std::is_nothrow_move_constructible_v<Vector>);
+} // namespace
+
+UNITTEST("libutl small_vector inline")
+{
+    Vector vector;
+    CHECK(vector.empty());
+    CHECK(vector.is_inline());
+
+    vector.push_back("a");
+    vector.emplace_back(3, 'b');
+
+    CHECK(vector.is_inline());
+    CHECK_EQUAL(vector.size(), 2UZ);
+    CHECK_EQUAL(vector.front(), "a");
+    CHECK_EQUAL(vector.back(), "bbb");
+}
+
+UNITTEST("libutl small_vector spill")
+{
+    Vector vector { "a", "b" };
+    vector.push_back(vector.front());
+    vector.insert(vector.begin(), "c");
+
+    CHECK(not vector.is_inline());
+    CHECK(vector.capacity() >= 4UZ);
+    auto const expected = std::to_array<std::string>({ "c", "a", "b", "a" });
+    CHECK(std::ranges::equal(vector, expected));
+
+    vector.pop_back();
+    CHECK_EQUAL(vector.size(), 3UZ);
+    CHECK_EQUAL(vector.at(2), "b");
+}
+
+UNITTEST("libutl small_vector copy and move")
+{
+    auto const small = Vector { "x" };
+    auto const large = Vector { "x", "y", "z" };
+
+    for (Vector const& original : { small, large }) {
+        Vector copy = original;
+        CHECK(copy == original);
+
+        Vector moved = std::move(copy);
+        CHECK(moved == original);
+        CHECK(copy.empty()); // NOLINT(bugprone-use-after-move)
+        CHECK(copy.is_inline());
+
+        Vector assigned { "w" };
+        assigned = std::move(moved);
+        CHECK(assigned == original);
+
+        assigned = small;
+        CHECK(assigned == small);
+    }
+
+    auto const vector = std::ranges::to<Vector>(std::views::repeat("r"s, 5));
+    CHECK_EQUAL(vector.size(), 5UZ);
+}
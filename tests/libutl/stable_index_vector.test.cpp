@@ -0,0 +1,77 @@
+#include <libutl/utilities.hpp>
+#include <libutl/stable_index_vector.hpp>
+#include <cppunittest/unittest.hpp>
+
+using namespace ki;
+
+namespace {
+    struct Index : utl::Vector_index<Index> {
+        using Vector_index::Vector_index;
+    };
+
+    using Vector = utl::Stable_index_vector<Index, std::string>;
+
+    template <typename T>
+    using Subscript = decltype(std::declval<T>()[Index(0UZ)]);
+
+    static_assert(std::same_as<Subscript<Vector&>, std::string&>);
+    static_assert(std::same_as<Subscript<Vector const&>, std::string const&>);
+    static_assert(std::forward_iterator<Vector::iterator>);
+    static_assert(std::forward_iterator<Vector::const_iterator>);
+} // namespace
+
+UNITTEST("libutl stable_index_vector")
+{
+    Vector vector;
+
+    auto const a = vector.push("hello, world");
+    auto const b = vector.push(5, 'a');
+
+    CHECK_EQUAL(vector[a], "hello, world");
+    CHECK_EQUAL(vector[b], "aaaaa");
+    CHECK_EQUAL(vector.size(), 2UZ);
+
+    auto const expected = std::to_array<std::string>({ "hello, world", "aaaaa" });
+    CHECK(std::ranges::equal(vector, expected));
+
+    if constexpr (utl::checked_indexing) {
+        CHECK_THROWS_AS(std::out_of_range, (void)vector[Index(2)]);
+    }
+}
+
+UNITTEST("libutl stable_index_vector stable references")
+{
+    Vector vector;
+
+    std::string const& first = vector[vector.push("first")];
+    for (std::size_t i = 0; i != 10'000; ++i) {
+        REQUIRE_EQUAL(vector[vector.push(std::to_string(i))], std::to_string(i));
+    }
+    CHECK_EQUAL(first, "first");
+    CHECK_EQUAL(vector.size(), 10'001UZ);
+    CHECK_EQUAL(vector[Index(10'000)], "9999");
+
+    Vector moved = std::move(vector);
+    CHECK_EQUAL(&moved[Index(0)], &first);
+    CHECK_EQUAL(vector.size(), 0UZ);
+}
+
+UNITTEST("libutl stable_index_vector concurrent reads")
+{
+    Vector vector;
+    (void)vector.push("0");
+
+    std::jthread reader([&] {
+        std::size_t read = 0;
+        while (read != 1'000) {
+            std::size_t const size = vector.size();
+            for (; read != size; ++read) {
+                REQUIRE_EQUAL(vector[Index(read)], std::to_string(read));
+            }
+        }
+    });
+
+    for (std::size_t i = 1; i != 1'000; ++i) {
+        (void)vector.push(std::to_string(i));
+    }
+}
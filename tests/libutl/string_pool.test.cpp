@@ -0,0 +1,85 @@
+#include <libutl/utilities.hpp>
+#include <libutl/string_pool.hpp>
+#include <cppunittest/unittest.hpp>
+
+using namespace ki;
+
+UNITTEST("libutl string_pool")
+{
+    utl::String_pool pool;
+
+    auto const a = pool.make("hello"sv);
+    auto const b = pool.make("world"sv);
+    auto const c = pool.make(std::string("hello"));
+
+    CHECK(a == c);
+    CHECK(a != b);
+    CHECK_EQUAL(pool.get(a), "hello");
+    CHECK_EQUAL(pool.get(b), "world");
+    CHECK(pool.make("world", utl::String_pool::hash("world")) == b);
+    CHECK_EQUAL(pool.get(pool.make(""sv)), "");
+}
+
+UNITTEST("libutl string_pool deterministic ids")
+{
+    // The hash is fixed, so it does not vary between standard libraries.
+    if constexpr (sizeof(std::size_t) == sizeof(std::uint64_t)) {
+        CHECK_EQUAL(utl::String_pool::hash("kieli"), 0x1369'51f0'e41d'2509UZ);
+    }
+
+    // Single-threaded insertion in the same order gives the same ids.
+    utl::String_pool first;
+    utl::String_pool second;
+    for (std::size_t i = 0; i != 1'000; ++i) {
+        auto const string = std::format("name{}", i);
+        REQUIRE(first.make(string) == second.make(string));
+    }
+}
+
+UNITTEST("libutl string_pool stable views")
+{
+    utl::String_pool pool;
+
+    auto const first = pool.get(pool.make("first"sv));
+    auto const large = std::string(100'000, 'x');
+
+    std::vector<utl::String_id> ids;
+    for (std::size_t i = 0; i != 10'000; ++i) {
+        ids.push_back(pool.make(std::format("name{}", i)));
+    }
+    CHECK_EQUAL(pool.get(pool.make(large)), large);
+
+    CHECK_EQUAL(first, "first");
+    for (std::size_t i = 0; i != ids.size(); ++i) {
+        REQUIRE_EQUAL(pool.get(ids[i]), std::format("name{}", i));
+        REQUIRE(pool.make(std::format("name{}", i)) == ids[i]);
+    }
+}
+
+UNITTEST("libutl string_pool concurrent interning")
+{
+    utl::String_pool pool;
+
+    constexpr std::size_t thread_count = 4;
+    constexpr std::size_t string_count = 5'000;
+
+    std::array<std::vector<utl::String_id>, thread_count> ids;
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t t = 0; t != thread_count; ++t) {
+            threads.emplace_back([&, t] {
+                for (std::size_t i = 0; i != string_count; ++i) {
+                    ids[t].push_back(pool.make(std::format("s{}", (i * (t + 1)) % string_count)));
+                }
+            });
+        }
+    }
+
+    for (std::size_t t = 0; t != thread_count; ++t) {
+        for (std::size_t i = 0; i != string_count; ++i) {
+            auto const string = std::format("s{}", (i * (t + 1)) % string_count);
+            REQUIRE_EQUAL(pool.get(ids[t][i]), string);
+            REQUIRE(pool.make(string) == ids[t][i]);
+        }
+    }
+}